@@ -22,7 +22,9 @@
 // to listen incoming connections from clients. This network server relies on
 // createServer() from bcl/Socket.h to process client's requests.
 // Multiple clinets can be connected at the same time.
-// A separate thread is used to maintain each connection.
+// A separate thread is used to maintain each connection by default. It is also
+// possible to multiplex all connections in a few event loops
+// (see bcl::net::ServerOptions).
 //
 //===----------------------------------------------------------------------===//
 
@@ -37,6 +39,7 @@
 
 #include <bcl/Socket.h>
 #include <functional>
+#include <memory>
 
 namespace bcl {
 namespace net {
@@ -62,6 +65,9 @@ enum class SocketStatus : uint8_t {
   Receive,
   Send,
   Close,
+  SendDrop,
+  SendHighWatermark,
+  SendLowWatermark,
 };
 
 /// Description of a network connection. If connection is active then
@@ -83,7 +89,7 @@ public:
   AddressT getClientAddress() const noexcept { return mClientAddress; }
   PortT getClientPort() const noexcept { return mClientPort; }
 
-  bool isActive() const noexcept { return mServerPort > 0 && mClientPort > 0; }
+  bool isActive() const noexcept { return !mClientAddress.empty(); }
 
 private:
   AddressT mServerAddress;
@@ -94,11 +100,239 @@ private:
 
 using SocketStatusHandler = std::function<void(SocketStatus, const Connection &)>;
 
+/// \brief Non-owning view of a received message.
+///
+/// The view refers to a receive buffer of a connection, so it is valid only
+/// during invocation of a listener. Use take() to access the message later
+/// without copying.
+class MessageView {
+public:
+  MessageView(const char *Data, std::size_t Size,
+      const std::shared_ptr<const void> &Owner) noexcept
+    : mData(Data), mSize(Size), mOwner(&Owner) {}
+
+  const char *data() const noexcept { return mData; }
+  std::size_t size() const noexcept { return mSize; }
+  bool empty() const noexcept { return mSize == 0; }
+
+  /// Copies the message.
+  std::string str() const { return std::string(mData, mSize); }
+
+  /// \brief Takes shared ownership of a buffer which contains the message.
+  ///
+  /// The returned pointer is equal to data(). The buffer is not reused to
+  /// receive other data until all owners are destroyed, after that it is
+  /// returned to a pool of buffers.
+  std::shared_ptr<const char> take() const {
+    return std::shared_ptr<const char>(*mOwner, mData);
+  }
+
+private:
+  const char *mData;
+  std::size_t mSize;
+  const std::shared_ptr<const void> *mOwner;
+};
+
+/// \brief Socket which provides access to received messages without copying.
+///
+/// Sockets which are passed to createServer() by startServer() implement
+/// this interface, use dynamic_cast to access it.
+class ViewSocket : public Socket<std::string> {
+public:
+  /// This represents a prototype of listeners which are invoked when
+  /// a message is received.
+  typedef std::function<void(const MessageView &)> ReceiveViewCallback;
+
+  /// \brief Adds the listener function to the end of array of listeners,
+  /// which are invoked when a message is received.
+  ///
+  /// These listeners are invoked before listeners which are registered with
+  /// receive(). If there are no such listeners, a received message is never
+  /// copied.
+  virtual void receiveView(const ReceiveViewCallback &F) const = 0;
+};
+
+/// Strategy to maintain active connections.
+enum class ServerMode : uint8_t {
+  /// A separate thread is launched to maintain each connection.
+  ThreadPerConnection,
+
+  /// Connections are multiplexed by a fixed number of event loops (epoll is
+  /// used on Linux and poll() on other POSIX systems). This mode is not
+  /// available on Windows, the ThreadPerConnection mode is used instead.
+  ///
+  /// Listeners must not block, because all connections of a loop wait for
+  /// them unless they are executed in a worker pool (see WorkerNumber).
+  /// Messages are sent asynchronously by default (see IsAsyncSend), so
+  /// a slow peer does not stall the loop.
+  EventLoop,
+};
+
+/// Way to split a stream of received bytes into messages.
+enum class FramingMode : uint8_t {
+  /// Each received chunk of data is treated as a separate message.
+  None,
+
+  /// Messages are separated by a delimiter (see ServerOptions::Delimiter).
+  /// The delimiter is appended to each sent message.
+  Delimiter,
+
+  /// Each message is preceded by its length, which is a 4-byte unsigned
+  /// integer in big-endian byte order. The length is prepended to each sent
+  /// message.
+  LengthPrefix,
+};
+
+/// Action which is performed if an output buffer of a connection is full.
+enum class OverflowPolicy : uint8_t {
+  /// Wait until a new message fits into the buffer. Buffered data are
+  /// written by an event loop meanwhile, so only the sending thread waits.
+  /// If the sending thread is the event loop itself (listeners are executed
+  /// without a worker pool), all connections of the loop wait.
+  Block,
+
+  /// Discard a new message and report SendDrop status.
+  Drop,
+
+  /// Report SendError status and close the connection.
+  Close,
+};
+
+/// Parameters of a server.
+struct ServerOptions {
+  /// Maximum number of connections which can be active at the same time.
+  /// Note, that an actual number of connections cannot exceed a maximum
+  /// number of sockets that cannot be opened simultaneously.
+  /// Use 0 to disable connection limits.
+  std::size_t ConnectionMaxNumber = 0;
+
+  /// Size of a buffer to store received chunks of data.
+  std::size_t BufferSize = 65535;
+
+  /// Strategy to maintain active connections.
+  ServerMode Mode = ServerMode::ThreadPerConnection;
+
+  /// Number of event loops in the EventLoop mode, 0 is treated as 1.
+  std::size_t EventLoopNumber = 1;
+
+  /// \brief Number of sockets which listen the same address in the EventLoop
+  /// mode, 0 is treated as 1.
+  ///
+  /// If it is greater than 1, sockets are bound with SO_REUSEPORT and the
+  /// system distributes incoming connections among them. Each socket has its
+  /// own accepting thread and event loops are divided between these threads,
+  /// so the number of event loops is increased to the number of sockets if
+  /// necessary. A single socket is used if the system does not balance
+  /// connections between such sockets (only Linux and FreeBSD do) and for
+  /// Unix domain sockets.
+  std::size_t AcceptorNumber = 1;
+
+  /// Bind each event loop and each accepting thread to a separate CPU core
+  /// in the EventLoop mode. The I-th accepting thread shares a core with
+  /// the first of its event loops. This is available on Linux only.
+  bool IsPinned = false;
+
+  /// Maximum length of a queue of pending connections of a listening socket,
+  /// 0 means the system limit (SOMAXCONN).
+  int Backlog = 0;
+
+  /// Disable Nagle's algorithm (TCP_NODELAY) for TCP connections, so small
+  /// messages are sent without waiting for acknowledgement of previous ones.
+  bool IsNoDelay = false;
+
+  /// Size of a kernel receive buffer (SO_RCVBUF) of a connection in bytes,
+  /// 0 means the system default. The system may adjust the specified value.
+  int ReceiveBufferSize = 0;
+
+  /// Size of a kernel send buffer (SO_SNDBUF) of a connection in bytes,
+  /// 0 means the system default. The system may adjust the specified value.
+  int SendBufferSize = 0;
+
+  /// Enable keepalive probes (SO_KEEPALIVE) for TCP connections.
+  bool IsKeepAlive = false;
+
+  /// Time in seconds a connection must be idle before the first keepalive
+  /// probe is sent, 0 means the system default.
+  int KeepAliveIdle = 0;
+
+  /// Time in seconds between keepalive probes, 0 means the system default.
+  int KeepAliveInterval = 0;
+
+  /// Number of unanswered keepalive probes before a connection is dropped,
+  /// 0 means the system default.
+  int KeepAliveCount = 0;
+
+  /// \brief Number of threads which execute createServer() and listeners of
+  /// sockets.
+  ///
+  /// Listeners of the same connection are executed one by one in the order
+  /// of events. If it is 0, listeners are executed in a thread which
+  /// maintains a connection.
+  std::size_t WorkerNumber = 0;
+
+  /// Way to split received data into messages. Listeners of a socket receive
+  /// exactly one complete message per call if framing is enabled.
+  FramingMode Framing = FramingMode::None;
+
+  /// Delimiter of messages in the Delimiter framing mode, it must not be
+  /// empty. Messages which are sent must not contain the delimiter.
+  std::string Delimiter = "\n";
+
+  /// Maximum size of a received message (without a delimiter or a length
+  /// prefix). A connection is closed with ReceiveError status if some message
+  /// exceeds the limit. Use 0 to disable the limit.
+  std::size_t MaxMessageSize = 0;
+
+  /// \brief Maximum size (in bytes) of messages which are sent from
+  /// listeners and are queued to be sent together.
+  ///
+  /// If it is not 0, messages which are sent from createServer() or from
+  /// listeners of a received message are stored in a connection buffer and
+  /// written by a single system call when listeners return or when the size
+  /// of stored messages exceeds this limit. A message which does not fit
+  /// into the limit is not copied. Use 0 to send each message immediately.
+  std::size_t BatchSize = 0;
+
+  /// \brief Enable asynchronous sending of messages.
+  ///
+  /// In this case, send() does not wait until a message is written to
+  /// a socket. Data which cannot be written immediately are stored in an
+  /// output buffer of a connection, and an event loop writes them when
+  /// the socket becomes writable. This is available in the EventLoop mode
+  /// only and it is ignored in other modes.
+  ///
+  /// If it is disabled, send() waits until a peer receives data. A listener
+  /// which is executed by an event loop (WorkerNumber is 0) stalls all
+  /// connections of the loop in this case, so use a worker pool if a peer
+  /// may be slow.
+  bool IsAsyncSend = true;
+
+  /// Maximum size of an output buffer of a connection (in bytes) in the
+  /// asynchronous mode. Use 0 to disable the limit.
+  std::size_t OutputMaxSize = 0;
+
+  /// Action which is performed if the output buffer size limit is exceeded.
+  OverflowPolicy Overflow = OverflowPolicy::Block;
+
+  /// SendHighWatermark status is reported if size of an output buffer
+  /// exceeds this value in the asynchronous mode.
+  std::size_t OutputHighWatermark = 1 << 20;
+
+  /// SendLowWatermark status is reported if size of an output buffer falls
+  /// to this value after SendHighWatermark status has been reported.
+  std::size_t OutputLowWatermark = 1 << 18;
+};
+
 /// Start server which is listening for connection.
 ///
 /// If new connection is established a separate thread is launched to maintain
 /// communcation.
-/// \param [in] Address Host name or an IPv4 address in standard dot notation.
+/// \param [in] Address Host name, an IPv4 address in standard dot notation
+///             or an IPv6 address. Use an empty string to listen all
+///             interfaces, IPv4 connections are accepted by an IPv6 socket
+///             if IPv6 is available. Use "unix:<path>" to listen a Unix
+///             domain socket (the port number is ignored in this case),
+///             it is not available on Windows.
 /// \param [in] PortNo Server port number.
 /// \param [in] ConnectionMaxNumber Maximum number of connections which can
 ///             be active at the same time. Note, that an actual number of
@@ -113,6 +347,47 @@ void startServer(const net::AddressT &Address, net::PortT PortNo,
     const net::SocketStatusHandler &on =
       [](net::SocketStatus, const net::Connection &){},
     std::size_t BufferSize = 65535);
+
+/// Start server which is listening for connection.
+///
+/// Connections are maintained according to a specified options.
+/// \param [in] Address Host name, an IPv4 address in standard dot notation
+///             or an IPv6 address. Use an empty string to listen all
+///             interfaces, IPv4 connections are accepted by an IPv6 socket
+///             if IPv6 is available. Use "unix:<path>" to listen a Unix
+///             domain socket (the port number is ignored in this case),
+///             it is not available on Windows.
+/// \param [in] PortNo Server port number.
+/// \param [in] Options Parameters of the server.
+/// \param [in] on Handler which will be invoked to process any event.
+///             All possible events are listed in bcl::net::SocketStatus.
+void startServer(const net::AddressT &Address, net::PortT PortNo,
+    const ServerOptions &Options,
+    const net::SocketStatusHandler &on =
+      [](net::SocketStatus, const net::Connection &){});
+
+/// \brief Connects a client with a server in the same process.
+///
+/// A pair of connected Unix domain sockets is used as a transport, so
+/// a listening socket is not necessary. A server side of the connection
+/// is passed to createServer() and it is maintained in a separate thread.
+/// This is useful for tests and to embed a server into an application.
+/// This is not available on Windows.
+/// \param [in] createClient Function which initializes listeners of
+///             a client side of the connection. It is invoked before any data
+///             are received.
+/// \param [in] Options Parameters of both sides of the connection. Options
+///             which describe a listening socket are ignored, the
+///             ThreadPerConnection mode is always used.
+/// \param [in] on Handler which will be invoked to process any event.
+/// \return Client side of the connection or nullptr on failure. Listeners of
+///         the client are invoked in a separate thread. The connection is
+///         closed when the returned socket is destroyed.
+std::shared_ptr<const ViewSocket> connectLocal(
+    const std::function<void(const ViewSocket *)> &createClient,
+    const ServerOptions &Options = ServerOptions(),
+    const net::SocketStatusHandler &on =
+      [](net::SocketStatus, const net::Connection &){});
 }
 }
 #endif//BCL_C_SOCKET_H
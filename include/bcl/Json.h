@@ -219,6 +219,70 @@
 // \endcode
 // The previous code defines some JSON object ExmpaleObject with a single field
 // Text.
+//
+// 9. If the same large JSON string is parsed multiple times it is possible to
+// build its structural index (json::Tape) once. The index allows parser to
+// skip nested objects and arrays without traversal of internal tokens.
+// \code
+//   json::Parser<Human, Dog> P(LargeJSON);
+//   P.buildTape();
+//   auto O = P.parse();
+//   // Share the index with another parser of the same string.
+//   json::Parser<> Other(LargeJSON, P.tape());
+// \endcode
+//
+// 10. A JSON-object can be also described with a single macro for each
+// name-value pair. This way does not limit the number of pairs in an object.
+// Generated macros JSON_OBJECT_PAIR_N and JSON_OBJECT_ROOT_PAIR_N are not used
+// here, so it is possible to define BCL_JSON_NO_OBJECT_MACROS before Json.h
+// is included to avoid preprocessing of these macros.
+// \code
+//   JSON_OBJECT_BEGIN(Human)
+//     JSON_PAIR(Name, std::string)
+//     JSON_PAIR(Age, unsigned)
+//   JSON_OBJECT_ROOT_PAIRS(Human, Name, Age)
+//     Human() : JSON_INIT_ROOT {}
+//   JSON_OBJECT_END(Human)
+//   JSON_DEFAULT_TRAITS(::, Human)
+// \endcode
+// Values can be accessed as usual, for example Obj[Human::Name].
+//
+// 11. It is possible to check that a JSON string can be converted to some
+// object without creation of this object. Note that duplicate elements of
+// sets and keys of maps are not checked in this mode.
+// \code
+//   json::Parser<Human, Dog> P(JSON);
+//   if (P.validate())        // Determine type of object by its identifier.
+//     dispatch(JSON);
+//   json::Parser<> Q(JSON);
+//   if (Q.validate<Human>()) // Type of object is known.
+//     dispatch(JSON);
+// \endcode
+//
+// 12. If BCL is configured with BCL_JSON_STATISTICS option, lexer collects
+// statistics which allow to find out which documents hit the slow paths of
+// a parser (see json::Statistics). Otherwise, counters are not updated and
+// statistics are always empty. This is a configuration option (see
+// bcl-config.h) rather than a macro of a translation unit, because templates
+// which are instantiated in the BCLJson library also collect statistics.
+// \code
+//   json::Parser<> P(JSON);
+//   P.parse(Obj);
+//   std::cout << P.statistics().Tokens << " tokens have been lexed\n";
+// \endcode
+//
+// 13. If a JSON string is received from untrusted source it is possible to
+// limit depth of nested values, number of elements in a value and length of
+// strings. Parsing stops as soon as some limit is exceeded.
+// \code
+//   json::Parser<Human> P(JSON);
+//   json::Limits L;
+//   L.MaxDepth = 64;
+//   L.MaxElements = 1024;
+//   L.MaxStringLength = 4096;
+//   P.setLimits(L);
+//   auto O = P.parse();
+// \endcode
 //===----------------------------------------------------------------------===//
 
 #ifndef BCL_JSON_H
@@ -227,15 +291,29 @@
 #include "cell.h"
 #include "Diagnostic.h"
 #include "utility.h"
+#include <bcl/bcl-config.h>
+#include <algorithm>
 #include <cctype>
+#include <cstdint>
+#include <initializer_list>
+#include <limits>
 #include <map>
 #include <memory>
 #include <set>
 #include <stack>
 #include <string>
 #include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
 #include <vector>
 
+#if defined __SSE2__ || defined _M_X64 || defined _M_IX86_FP && _M_IX86_FP >= 2
+# define BCL_JSON_SSE2
+# include <emmintrin.h>
+#endif
+
 #define JSON_ERROR_1 "unexpected end of string"
 #define JSON_ERROR_2 "unexpected character '%c' expected '%c'"
 #define JSON_ERROR_3 "unknown json string, identifier '%s' is not found"
@@ -245,8 +323,18 @@
 #define JSON_ERROR_7 "uninitialized elements in array"
 #define JSON_ERROR_8 "target object type does not support duplicate of keys"
 #define JSON_ERROR_9 "illegal value"
+#define JSON_ERROR_10 "depth of nested values exceeds limit %zu"
+#define JSON_ERROR_11 "number of elements exceeds limit %zu"
+#define JSON_ERROR_12 "length of string exceeds limit %zu"
 #define JSON_ERROR(C) C, JSON_ERROR_##C
 
+#ifdef BCL_JSON_STATISTICS
+# define JSON_STATISTIC(Lex_, Counter_, Inc_) \
+  (Lex_).count(&::json::Statistics::Counter_, (Inc_))
+#else
+# define JSON_STATISTIC(Lex_, Counter_, Inc_) ((void)0)
+#endif
+
 #define JSON_OBJECT_BEGIN(Object_) \
 namespace json_ { struct Object_##Impl {
 
@@ -269,6 +357,15 @@ static constexpr json_::Object_##Impl::Name_ Name_ \
 #define JSON_VALUE(Name_, Type_) \
 struct Name_ { JSON_NAME(Name_) using ValueType = Type_; };
 
+/// \brief Specifies a JSON name-value pair and a way to access its value.
+///
+/// This combines JSON_VALUE and JSON_ACCESS. A list of pairs declared in this
+/// way should be passed to JSON_OBJECT_PAIRS or JSON_OBJECT_ROOT_PAIRS.
+/// Type of a value is the last parameter, so it may contain commas.
+#define JSON_PAIR(Name_, ...) \
+struct Name_ { JSON_NAME(Name_) using ValueType = __VA_ARGS__; }; \
+static constexpr struct Name_ Name_ = {};
+
 /// Defines structure of a sub-object.
 #define JSON_OBJECT(Object_, ...) \
   using Base = bcl::StaticMap<__VA_ARGS__>; }; } \
@@ -281,6 +378,27 @@ struct Object_ : \
   public json_::Object_##Impl::Base, public ::json::Object { \
   JSON_NAME(Object_)
 
+/// \brief Defines structure of a sub-object with pairs declared with JSON_PAIR.
+///
+/// There is no limit on the number of pairs. A list of cells is deduced from
+/// a list of names by a variadic template, so only one macro should be
+/// expanded for each pair.
+#define JSON_OBJECT_PAIRS(Object_, ...) \
+  using Base = decltype(::json::detail::staticMap(__VA_ARGS__)); }; } \
+struct Object_ : \
+  public json_::Object_##Impl::Base, public json_::Object_##Impl {
+
+/// \brief Defines structure of a top-level object with pairs declared with
+/// JSON_PAIR.
+///
+/// \sa JSON_OBJECT_PAIRS
+#define JSON_OBJECT_ROOT_PAIRS(Object_, ...) \
+  using Base = decltype(::json::detail::staticMap(__VA_ARGS__)); }; } \
+struct Object_ : \
+  public json_::Object_##Impl::Base, public json_::Object_##Impl, \
+  public ::json::Object { \
+  JSON_NAME(Object_)
+
 /// Initializes object with a list of values.
 #define JSON_INIT(Object_, ...) json_::Object_##Impl::Base(__VA_ARGS__)
 
@@ -302,6 +420,15 @@ template<> struct Traits<namespace_ Object_> : \
 }
 
 namespace json {
+namespace detail {
+/// \brief Returns type of a static map which consists of cells with
+/// specified keys.
+///
+/// This function is not defined, it should be used in unevaluated context to
+/// convert a list of objects to a list of their types.
+template<class... Keys> bcl::StaticMap<Keys...> staticMap(Keys...);
+}
+
 /// This is a base class for all JSON objects which can be obtained when
 /// a string represented JSON is parsed.
 ///
@@ -370,6 +497,429 @@ typedef std::string String;
 /// Position in a JSON string.
 typedef std::string::size_type Position;
 
+namespace detail {
+/// Returns number of trailing zero bits in a specified non-zero value.
+inline unsigned countTrailingZeros(std::uint64_t Value) noexcept {
+  assert(Value != 0 && "Value must not be zero!");
+#if defined __GNUC__ || defined __clang__
+  return static_cast<unsigned>(__builtin_ctzll(Value));
+#else
+  unsigned Count = 0;
+  for (; !(Value & 1); Value >>= 1, ++Count);
+  return Count;
+#endif
+}
+
+/// \brief This scans a JSON string looking for structural characters outside
+/// of strings.
+///
+/// The string is processed by blocks of 64 characters. For each block bit
+/// masks of quotes, escapes, braces, brackets and commas are computed at first.
+/// Mask computation is branch-free so it is suitable for automatic
+/// vectorization. Then only bits which are set in these masks are visited, so
+/// characters which can not affect structure of a JSON string (for example,
+/// characters inside strings) are skipped in bulk. Strings are recognized in
+/// the same way as in json::Lexer.
+class StructuralScanner {
+  /// Bit masks of characters in a block.
+  struct Block {
+    std::uint64_t Quote = 0;
+    std::uint64_t Escape = 0;
+    std::uint64_t Structural = 0;
+  };
+
+public:
+  /// Number of characters in a block.
+  static constexpr unsigned BlockSize = 64;
+
+  /// \brief Creates scanner for a specified string.
+  ///
+  /// If WithCommas is false then commas are not reported.
+  StructuralScanner(const String &JSON, bool WithCommas) noexcept :
+    mJSON(JSON), mWithCommas(WithCommas) {}
+
+  /// \brief Visits structural characters (braces, brackets and commas) which
+  /// are located outside of strings.
+  ///
+  /// Scan starts at a specified position From which must not be inside
+  /// a string. Visitor has a prototype `bool(char Ch, Position Pos)`, scan
+  /// stops if it returns false.
+  /// \return Position at which scan has been stopped or the length of the
+  /// JSON string if the whole string has been visited.
+  template<class VisitorT> Position scan(Position From, VisitorT &&Visit) {
+    mInString = false;
+    bool PrevEscape = false;
+    for (Position Base = From; Base < mJSON.size(); Base += BlockSize) {
+      auto Size = static_cast<unsigned>(
+        std::min<Position>(BlockSize, mJSON.size() - Base));
+      Block B;
+      load(mJSON.data() + Base, Size, B);
+      if (!B.Escape && !PrevEscape) {
+        // Each quote opens or closes a string, so characters inside strings
+        // can be determined without visiting quotes one by one.
+        auto InString = prefixXor(B.Quote);
+        if (mInString)
+          InString = ~InString;
+        for (auto Mask = B.Structural & ~InString; Mask; Mask &= Mask - 1) {
+          auto I = countTrailingZeros(Mask);
+          if (!Visit(mJSON[Base + I], Base + I))
+            return Base + I;
+        }
+        mInString = InString >> (Size - 1) & 1;
+        continue;
+      }
+      std::uint64_t Done = 0;
+      for (;;) {
+        auto Mask = (mInString ? B.Quote : B.Quote | B.Structural) & ~Done;
+        if (!Mask)
+          break;
+        auto I = countTrailingZeros(Mask);
+        Done = I + 1 == BlockSize ? ~std::uint64_t(0) :
+          (std::uint64_t(1) << (I + 1)) - 1;
+        if (B.Quote >> I & 1) {
+          if (!mInString)
+            mInString = true;
+          else if (!(I > 0 ? B.Escape >> (I - 1) & 1 : PrevEscape))
+            mInString = false;
+        } else if (!Visit(mJSON[Base + I], Base + I)) {
+          return Base + I;
+        }
+      }
+      PrevEscape = B.Escape >> (Size - 1) & 1;
+    }
+    return mJSON.size();
+  }
+
+  /// Returns true if the last scan has been finished inside a string.
+  bool inString() const noexcept { return mInString; }
+
+private:
+  /// Computes bit masks for a block of a specified size.
+  void load(const char *Data, unsigned Size, Block &B) const noexcept {
+#ifdef BCL_JSON_SSE2
+    if (Size == BlockSize) {
+      auto Quote = _mm_set1_epi8(static_cast<char>(Token::QUOTE));
+      auto Escape = _mm_set1_epi8(static_cast<char>(Token::ESCAPE));
+      auto Comma = _mm_set1_epi8(static_cast<char>(Token::COMMA));
+      // Setting bit 0x20 maps '[' (0x5B) to '{' (0x7B) and ']' (0x5D)
+      // to '}' (0x7D), so both kinds of braces are found by two compares.
+      auto Case = _mm_set1_epi8(0x20);
+      auto Left = _mm_set1_epi8(static_cast<char>(Token::LEFT_BRACE));
+      auto Right = _mm_set1_epi8(static_cast<char>(Token::RIGHT_BRACE));
+      for (unsigned I = 0; I < BlockSize; I += 16) {
+        auto Chunk = _mm_loadu_si128(
+          reinterpret_cast<const __m128i *>(Data + I));
+        auto Folded = _mm_or_si128(Chunk, Case);
+        auto Structural = _mm_or_si128(_mm_cmpeq_epi8(Folded, Left),
+          _mm_cmpeq_epi8(Folded, Right));
+        if (mWithCommas)
+          Structural = _mm_or_si128(Structural, _mm_cmpeq_epi8(Chunk, Comma));
+        B.Quote |= std::uint64_t(static_cast<std::uint16_t>(
+          _mm_movemask_epi8(_mm_cmpeq_epi8(Chunk, Quote)))) << I;
+        B.Escape |= std::uint64_t(static_cast<std::uint16_t>(
+          _mm_movemask_epi8(_mm_cmpeq_epi8(Chunk, Escape)))) << I;
+        B.Structural |= std::uint64_t(static_cast<std::uint16_t>(
+          _mm_movemask_epi8(Structural))) << I;
+      }
+      return;
+    }
+#endif
+    for (unsigned I = 0; I < Size; ++I) {
+      auto Ch = Data[I];
+      B.Quote |= std::uint64_t(Ch == static_cast<char>(Token::QUOTE)) << I;
+      B.Escape |= std::uint64_t(Ch == static_cast<char>(Token::ESCAPE)) << I;
+      B.Structural |= std::uint64_t(
+        Ch == static_cast<char>(Token::LEFT_BRACE) ||
+        Ch == static_cast<char>(Token::RIGHT_BRACE) ||
+        Ch == static_cast<char>(Token::LEFT_BRACKET) ||
+        Ch == static_cast<char>(Token::RIGHT_BRACKET) ||
+        (mWithCommas && Ch == static_cast<char>(Token::COMMA))) << I;
+    }
+  }
+
+  /// Returns a mask where each bit is a XOR of all lower bits (including
+  /// itself) in a specified mask.
+  static std::uint64_t prefixXor(std::uint64_t Mask) noexcept {
+    Mask ^= Mask << 1;
+    Mask ^= Mask << 2;
+    Mask ^= Mask << 4;
+    Mask ^= Mask << 8;
+    Mask ^= Mask << 16;
+    Mask ^= Mask << 32;
+    return Mask;
+  }
+
+  const String &mJSON;
+  bool mWithCommas;
+  bool mInString = false;
+};
+
+/// \brief This is a hash table which maps identifiers of JSON objects
+/// to some values.
+///
+/// Identifiers can be looked up directly in a JSON string, so creation of
+/// temporary strings is not necessary. Open addressing with linear probing is
+/// used to resolve collisions.
+template<class ValueTy> class NameTable {
+  typedef std::pair<std::string, ValueTy> EntryTy;
+  static constexpr std::size_t EmptyBucket = ~std::size_t(0);
+
+public:
+  /// \brief Creates table with a specified list of pairs (name, value).
+  ///
+  /// If some name is repeated the first value is used.
+  NameTable(std::initializer_list<EntryTy> Init) {
+    std::size_t Size = 1;
+    while (Size < 2 * Init.size())
+      Size *= 2;
+    mBuckets.assign(Size, std::size_t(EmptyBucket));
+    mEntries.reserve(Init.size());
+    for (auto &E : Init) {
+      auto &Bucket = mBuckets[findBucket(E.first.data(), E.first.size())];
+      if (Bucket != EmptyBucket)
+        continue;
+      Bucket = mEntries.size();
+      mEntries.push_back(E);
+    }
+  }
+
+  /// Returns value associated with a name [Name, Name + Size) or nullptr.
+  const ValueTy * find(const char *Name, std::size_t Size) const noexcept {
+    auto Bucket = mBuckets[findBucket(Name, Size)];
+    return Bucket != EmptyBucket ? &mEntries[Bucket].second : nullptr;
+  }
+
+  /// Returns number of names in the table.
+  std::size_t size() const noexcept { return mEntries.size(); }
+
+private:
+  /// Computes FNV-1a hash of a specified name.
+  static std::size_t hash(const char *Name, std::size_t Size) noexcept {
+    std::uint64_t Hash = 14695981039346656037ull;
+    for (std::size_t I = 0; I < Size; ++I) {
+      Hash ^= static_cast<unsigned char>(Name[I]);
+      Hash *= 1099511628211ull;
+    }
+    return static_cast<std::size_t>(Hash);
+  }
+
+  /// Returns index of a bucket which contains a specified name or index of
+  /// an empty bucket which can be used to store this name.
+  std::size_t findBucket(const char *Name, std::size_t Size) const noexcept {
+    auto Mask = mBuckets.size() - 1;
+    for (auto Idx = hash(Name, Size) & Mask;; Idx = (Idx + 1) & Mask) {
+      auto Bucket = mBuckets[Idx];
+      if (Bucket == EmptyBucket ||
+          mEntries[Bucket].first.compare(0, EntryTy::first_type::npos,
+            Name, Size) == 0)
+        return Idx;
+    }
+  }
+
+  std::vector<EntryTy> mEntries;
+  std::vector<std::size_t> mBuckets;
+};
+}
+
+/// \brief This is a structural index of a JSON string.
+///
+/// The tape is built once per JSON string and records position of each
+/// compound value (object or array), position of the matching closing brace
+/// or bracket and number of elements in the value. Lexer uses this tape to
+/// skip compound values without traversal of internal tokens. A single tape
+/// can be shared between lexers which process the same JSON string.
+class Tape {
+public:
+  /// Description of a compound value.
+  struct Entry {
+    /// Position of a left brace or a left bracket.
+    Position Open;
+
+    /// Position of a matching right brace or a right bracket.
+    Position Close;
+
+    /// Number of elements (or name-value pairs) in the value.
+    Position Size;
+  };
+
+  typedef std::vector<Entry>::const_iterator iterator;
+  typedef iterator const_iterator;
+
+  /// Creates an empty tape.
+  Tape() = default;
+
+  /// Builds a tape for a specified JSON string.
+  explicit Tape(const String &JSON) { build(JSON); }
+
+  /// \brief Builds a tape for a specified JSON string.
+  ///
+  /// Strings are recognized in the same way as in json::Lexer.
+  /// \return False if braces or brackets are not balanced, in this case the
+  /// tape becomes empty and invalid.
+  bool build(const String &JSON) {
+    detail::StructuralScanner Scanner(JSON, true);
+    auto Stop = scan(Scanner, JSON, 0, false);
+    if (Stop != JSON.size() || Scanner.inString() || !mStack.empty()) {
+      mEntries.clear();
+      return false;
+    }
+    mIsValid = true;
+    return true;
+  }
+
+  /// \brief Builds a tape for a compound value which starts at a specified
+  /// position in a JSON string.
+  ///
+  /// Only the value and values nested in it are described in the tape, the
+  /// rest of the string is not scanned. The value is the first entry in
+  /// the tape. Memory which has been allocated for the previous content of
+  /// the tape is reused.
+  /// \return False if there is no compound value at the specified position
+  /// or it is not closed, in this case the tape becomes empty and invalid.
+  bool build(const String &JSON, Position Open) {
+    detail::StructuralScanner Scanner(JSON, true);
+    auto Stop = scan(Scanner, JSON, Open, true);
+    if (Stop == JSON.size() || !mStack.empty() || mEntries.empty() ||
+        mEntries.front().Open != Open) {
+      mEntries.clear();
+      return false;
+    }
+    mIsValid = true;
+    return true;
+  }
+
+  /// Returns true if the tape has been successfully built.
+  bool isValid() const noexcept { return mIsValid; }
+
+  /// Returns number of compound values in the tape.
+  std::size_t size() const noexcept { return mEntries.size(); }
+
+  /// Returns true if there is no compound values in the tape.
+  bool empty() const noexcept { return mEntries.empty(); }
+
+  iterator begin() const { return mEntries.begin(); }
+  iterator end() const { return mEntries.end(); }
+
+  /// \brief Returns description of a compound value which starts at
+  /// a specified position or nullptr.
+  ///
+  /// Hint is an index of the tape entry which has been accessed previously,
+  /// the search starts from this entry and gallops forward. So, if values are
+  /// looked up in the order of their appearance in the JSON string the search
+  /// takes almost constant time. On exit Hint is updated.
+  const Entry * find(Position Open, std::size_t &Hint) const {
+    auto Less = [](const Entry &E, Position P) { return E.Open < P; };
+    auto I = mEntries.begin(), EI = mEntries.end();
+    if (Hint < mEntries.size() && mEntries[Hint].Open <= Open) {
+      std::size_t Lo = Hint, Step = 1, Hi = Hint + 1;
+      while (Hi < mEntries.size() && mEntries[Hi].Open < Open) {
+        Lo = Hi;
+        Step *= 2;
+        Hi = std::min(Lo + Step, mEntries.size());
+      }
+      I = std::lower_bound(mEntries.begin() + Lo,
+        mEntries.begin() + std::min(Hi + 1, mEntries.size()), Open, Less);
+    } else {
+      I = std::lower_bound(I, EI, Open, Less);
+    }
+    if (I == EI || I->Open != Open)
+      return nullptr;
+    Hint = I - mEntries.begin();
+    return &*I;
+  }
+
+private:
+  /// \brief Scans a JSON string from a specified position and describes
+  /// compound values in the tape.
+  ///
+  /// Nested values are tracked with an explicit stack, so the scan does not
+  /// depend on the depth of nesting. If IsValue is true the scan stops when
+  /// the first compound value is closed.
+  /// \return Position where the scan has been stopped.
+  Position scan(detail::StructuralScanner &Scanner, const String &JSON,
+      Position From, bool IsValue) {
+    mEntries.clear();
+    mStack.clear();
+    mIsValid = false;
+    return Scanner.scan(From, [this, &JSON, IsValue](char Ch, Position Pos) {
+      switch (Ch) {
+      case static_cast<char>(Token::LEFT_BRACE):
+      case static_cast<char>(Token::LEFT_BRACKET):
+        mStack.emplace_back(mEntries.size(), 0);
+        mEntries.push_back(Entry{ Pos, Pos, 0 });
+        return true;
+      case static_cast<char>(Token::COMMA):
+        if (!mStack.empty())
+          ++mStack.back().second;
+        return true;
+      default:
+        if (mStack.empty())
+          return false;
+        close(JSON, mEntries[mStack.back().first], Pos, mStack.back().second);
+        mStack.pop_back();
+        return !IsValue || !mStack.empty();
+      }
+    });
+  }
+
+  /// Finalizes description of a compound value which is closed at Close
+  /// and contains a specified number of top-level commas.
+  static void close(const String &JSON, Entry &E, Position Close,
+      Position Commas) {
+    E.Close = Close;
+    auto I = E.Open + 1;
+    for (; I < Close && std::isspace(JSON[I]); ++I);
+    E.Size = I == Close ? 0 : Commas + 1;
+  }
+
+  std::vector<Entry> mEntries;
+  std::vector<std::pair<std::size_t, Position>> mStack;
+  bool mIsValid = false;
+};
+
+/// \brief Statistics of a lexer.
+///
+/// Counters are updated only if BCL is configured with BCL_JSON_STATISTICS
+/// option.
+struct Statistics {
+  /// Number of lexed tokens.
+  std::size_t Tokens = 0;
+
+  /// Number of bytes in compound values which have been skipped without
+  /// lexing of internal tokens.
+  std::size_t SkippedBytes = 0;
+
+  /// Number of compound values which have been pre-scanned to determine
+  /// number of keys (see Parser::numberOfKeys()).
+  std::size_t KeyScans = 0;
+
+  /// Number of rewinds to a previously stored position.
+  std::size_t Rewinds = 0;
+
+  /// Number of memory allocations (buffers and nodes of containers)
+  /// requested by traits.
+  std::size_t Allocations = 0;
+
+  /// Number of errors which have been inserted in a list of errors,
+  /// internal errors are also considered.
+  std::size_t Errors = 0;
+};
+
+/// \brief Limits which are checked during parsing of a JSON string.
+///
+/// By default nothing is limited.
+struct Limits {
+  /// Maximum number of nested objects and arrays.
+  Position MaxDepth = std::numeric_limits<Position>::max();
+
+  /// Maximum number of elements (or name-value pairs) in an object or
+  /// an array, this also limits indexes of elements in an array.
+  Position MaxElements = std::numeric_limits<Position>::max();
+
+  /// Maximum number of characters between quotes in a string.
+  Position MaxStringLength = std::numeric_limits<Position>::max();
+};
+
 /// This is a lexer for a JSON string.
 class Lexer: private bcl::Uncopyable {
   /// Checks whether a specified character Ch is a quote.
@@ -415,27 +965,37 @@ class Lexer: private bcl::Uncopyable {
 
   /// State of a lexer.
   struct State {
-    State(Position S, Position E, Position N, Token T, bool IsInt) :
-      mStart(S), mEnd(E), mNext(N), mToken(T), mIsIntegral(IsInt) {}
+    State(Position S, Position E, Position N, Token T, bool IsInt,
+        Position D) :
+      mStart(S), mEnd(E), mNext(N), mToken(T), mIsIntegral(IsInt),
+      mDepth(D) {}
 
     Position mStart = 0;
     Position mEnd = 0;
     Position mNext = 0;
     Token mToken;
     bool mIsIntegral = false;
+    Position mDepth = 0;
   };
 
 public:
   /// Constructs a lexer for a specified JSON string.
   explicit Lexer(const String &JSON) : mJSON(JSON), mErrors("json error") {}
 
+  /// \brief Constructs a lexer for a specified JSON string.
+  ///
+  /// The specified tape must be built for the same JSON string.
+  Lexer(const String &JSON, std::shared_ptr<const Tape> T) :
+      mJSON(JSON), mErrors("json error"), mTape(std::move(T)) {}
+
   /// Goes to a next token in a JSON string.
   ///
   /// The token is represented by characters in a range [start(), end()].
   /// To access a character following the token use next().
   /// \return `true` if JSON string has been successfully traversed. If errors
   /// have been occurred they will be stored in errors() container and this
-  /// returns `false`.
+  /// returns `false`. Exceeded depth of nested values and length of strings
+  /// (see limits()) are also considered as errors.
   bool goToNext() {
     for (; mNext < mJSON.size() && std::isspace(mJSON[mNext]); ++mNext);
     mToken = Token::INVALID;
@@ -445,10 +1005,15 @@ public:
       return false;
     }
     mStart = mEnd = mNext;
+    JSON_STATISTIC(*this, Tokens, 1);
     if (isQuote(mJSON[mNext])) {
       for (++mNext; mNext < mJSON.size(); ++mNext) {
         if (isQuote(mJSON[mNext]) && !isEscape(mJSON[mNext - 1])) {
           mEnd = mNext++;
+          if (mEnd - mStart - 1 > mLimits.MaxStringLength) {
+            mErrors.insert(JSON_ERROR(12), mStart, mLimits.MaxStringLength);
+            return false;
+          }
           mToken = Token::IDENTIFIER;
           return true;
         }
@@ -475,6 +1040,16 @@ public:
       return true;
     }
     mEnd = mNext;
+    if (isLeftBrace(mJSON[mStart]) || isLeftBracket(mJSON[mStart])) {
+      if (mDepth == mLimits.MaxDepth) {
+        mErrors.insert(JSON_ERROR(10), mStart, mLimits.MaxDepth);
+        return false;
+      }
+      ++mDepth;
+    } else if ((isRightBrace(mJSON[mStart]) ||
+                isRightBracket(mJSON[mStart])) && mDepth > 0) {
+      --mDepth;
+    }
     mToken = static_cast<Token>(mJSON[mStart]);
     ++mNext;
     return true;
@@ -513,8 +1088,25 @@ public:
     return false;
   }
 
-  /// Skips all characters in a JSON string between braces or brackets,
+  /// \brief Checks that number of elements in a compound value does not
+  /// exceed the limit.
+  ///
+  /// \return If the limit is exceeded this method returns false and add
+  /// appropriate error in the errors collection.
+  bool checkElements(Position Count) {
+    if (Count <= mLimits.MaxElements)
+      return true;
+    mErrors.insert(JSON_ERROR(11), mStart, mLimits.MaxElements);
+    return false;
+  }
+
+  /// \brief Skips all characters in a JSON string between braces or brackets,
   /// return false if some errors have been occurred.
+  ///
+  /// If a tape is available or the value has been indexed (see indexValue())
+  /// the lexer jumps to the matching brace or bracket at once. Otherwise,
+  /// internal tokens are not lexed, the string is scanned by blocks with
+  /// detail::StructuralScanner instead.
   bool skipInternal() {
     Token Last;
     if (is(Token::LEFT_BRACKET))
@@ -523,24 +1115,44 @@ public:
       Last = Token::RIGHT_BRACE;
     else
       return false;
+    if (auto *E = findInTape(mStart)) {
+      JSON_STATISTIC(*this, SkippedBytes, E->Close + 1 - mStart);
+      mNext = E->Close;
+      return goToNext() && checkSpecial(Last);
+    }
     int Level = 0;
-    while (goToNext()) {
-      if ((isRightBrace(mJSON[mStart]) || isRightBracket(mJSON[mStart])) &&
-          Level-- == 0)
-        return checkSpecial(Last);
-      if (isLeftBrace(mJSON[mStart]) || isLeftBracket(mJSON[mStart]))
+    detail::StructuralScanner Scanner(mJSON, false);
+    auto Close = Scanner.scan(mNext, [&Level](char Ch, Position) {
+      if (isLeftBrace(Ch) || isLeftBracket(Ch))
         ++Level;
+      else if (Level-- == 0)
+        return false;
+      return true;
+    });
+    if (Close == mJSON.size()) {
+      mErrors.insert(JSON_ERROR(1), Close);
+      mStart = mEnd = mNext = mJSON.size();
+      mToken = Token::INVALID;
+      return false;
     }
-    return false;
+    JSON_STATISTIC(*this, SkippedBytes, Close + 1 - mStart);
+    mNext = Close;
+    return goToNext() && checkSpecial(Last);
   }
 
   /// Resets current lexer position.
   void resetPosition() noexcept {
     mStart = mEnd = mNext = 0;
     mToken = Token::INVALID;
+    mDepth = 0;
   }
 
-  /// Sets lexer position and parses the first token at the new position.
+  /// \brief Sets lexer position and parses the first token at the new
+  /// position.
+  ///
+  /// Depth of nested values is not changed, so the new position should be
+  /// at the same level as the current one (for example, a key of the
+  /// current value).
   void setPosition(Position Start) {
     mStart = mEnd = mNext = Start;
     mToken = Token::INVALID;
@@ -550,19 +1162,23 @@ public:
   /// Saves the current position in an internal stack, it can be restored with
   /// restorePosition() method.
   void storePosition() {
-    mStates.emplace(State(mStart, mEnd, mNext, mToken, mIsIntegral));
+    mStates.emplace(
+      State(mStart, mEnd, mNext, mToken, mIsIntegral, mDepth));
   }
 
-  /// Restores the last stored position. If there is no stored positions do
-  /// nothing.
+  /// Restores the last stored position and removes it from the internal
+  /// stack. If there is no stored positions do nothing.
   void restorePosition() {
     if (mStates.empty())
       return;
+    JSON_STATISTIC(*this, Rewinds, 1);
     mStart = mStates.top().mStart;
     mEnd = mStates.top().mEnd;
     mNext = mStates.top().mNext;
     mToken = mStates.top().mToken;
     mIsIntegral = mStates.top().mIsIntegral;
+    mDepth = mStates.top().mDepth;
+    mStates.pop();
   }
 
   /// \brief Returns start position of a current token in the JSON string.
@@ -578,6 +1194,16 @@ public:
   /// Returns true if a current token is equal to a specified one.
   bool is(Token Token) const noexcept { return mToken == Token; }
 
+  /// Returns number of objects and arrays which contain a current token,
+  /// if the token is '{' or '[' the value it opens is also considered.
+  Position depth() const noexcept { return mDepth; }
+
+  /// Returns limits which are checked during parsing.
+  const Limits & limits() const noexcept { return mLimits; }
+
+  /// Sets limits which are checked during parsing.
+  void setLimits(const Limits &L) noexcept { mLimits = L; }
+
   /// Returns true if a current token is an integral number.
   bool isIntegral() const noexcept {
     return mToken == Token::NUMBER && mIsIntegral;
@@ -600,6 +1226,21 @@ public:
     return !errors().empty() || errors().internal_size() > 0;
   }
 
+  /// Returns statistics which have been collected by this lexer.
+  Statistics statistics() const {
+    auto Stat = mStatistics;
+#ifdef BCL_JSON_STATISTICS
+    Stat.Errors = errors().size() + errors().internal_size();
+#endif
+    return Stat;
+  }
+
+  /// Increments a specified counter, use JSON_STATISTIC macro instead of
+  /// direct calls of this method.
+  void count(std::size_t Statistics::*Counter, std::size_t Inc) noexcept {
+    mStatistics.*Counter += Inc;
+  }
+
   /// Discards limiting quotes of the current token, if it is an identifier, or
   /// does nothing.
   std::pair<Position, Position> discardQuote() const noexcept {
@@ -611,15 +1252,79 @@ public:
   /// Returns a JSON string.
   const String & json() const noexcept { return mJSON; }
 
+  /// \brief Builds a structural index for the JSON string.
+  ///
+  /// \return False if the JSON string is malformed and the tape can not be
+  /// built. In this case the lexer does not use the tape.
+  bool buildTape() {
+    auto T = std::make_shared<Tape>();
+    auto IsValid = T->build(mJSON);
+    mTape = std::move(T);
+    mTapeHint = 0;
+    return IsValid;
+  }
+
+  /// Attaches a tape which has been built for the same JSON string.
+  void setTape(std::shared_ptr<const Tape> T) noexcept {
+    mTape = std::move(T);
+    mTapeHint = 0;
+  }
+
+  /// Returns a structural index for the JSON string or nullptr.
+  const std::shared_ptr<const Tape> & tape() const noexcept { return mTape; }
+
+  /// \brief Returns description of a compound value which starts at
+  /// a specified position.
+  ///
+  /// If there is no tape for the whole JSON string, the index of the last
+  /// value built with indexValue() is used.
+  /// \return Nullptr if there is no valid tape or the specified position is not
+  /// a beginning of a compound value.
+  const Tape::Entry * findInTape(Position Open) const {
+    if (mTape && mTape->isValid())
+      return mTape->find(Open, mTapeHint);
+    if (mValueTape.isValid())
+      return mValueTape.find(Open, mValueTapeHint);
+    return nullptr;
+  }
+
+  /// \brief Returns description of a compound value which starts at
+  /// the current token and builds its structural index if necessary.
+  ///
+  /// The value is scanned once, nested values are tracked with an explicit
+  /// stack. So, subsequent searches of nested values and skips of them
+  /// take constant time regardless of the depth of nesting. The index is
+  /// kept until some value outside it is indexed.
+  /// \return Nullptr if the current token is neither '{' nor '[' or the
+  /// value is not closed.
+  const Tape::Entry * indexValue() {
+    if (auto *E = findInTape(mStart))
+      return E;
+    if (mTape && mTape->isValid())
+      return nullptr;
+    JSON_STATISTIC(*this, KeyScans, 1);
+    mValueTapeHint = 0;
+    if (!mValueTape.build(mJSON, mStart))
+      return nullptr;
+    return &*mValueTape.begin();
+  }
+
 private:
   String mJSON;
   bcl::Diagnostic mErrors;
+  std::shared_ptr<const Tape> mTape;
+  mutable std::size_t mTapeHint = 0;
+  Tape mValueTape;
+  mutable std::size_t mValueTapeHint = 0;
   Position mStart = 0;
   Position mEnd = 0;
   Position mNext = 0;
   Token mToken;
   bool mIsIntegral = false;
+  Position mDepth = 0;
+  Limits mLimits;
   std::stack<State> mStates;
+  Statistics mStatistics;
 };
 
 /// \brief This implements methods to convert value in a JSON string to
@@ -649,6 +1354,18 @@ private:
 /// - static void unparse(String &JSON, const Ty &) -
 ///     Converts value to string and stores it ina JSON string.
 ///
+/// The following static methods are optional, they are used to check a JSON
+/// string without conversion of its values (see Parser::validate()):
+/// - static bool validate(Lexer &) -
+///     Checks that value from a JSON string can be converted to a type Ty.
+///     Lexer parameter points to the first value token. On success the lexer
+///     must point to the last value token as after parse().
+///     If this method is not implemented, the value is parsed into
+///     a temporary object of type Ty.
+/// - static bool validate(Lexer &, std::pair<Position, Position>) -
+///     This is a counterpart of the last parse() method which is invoked
+///     by Parser<>::traverse(Lexer &) to check elements of compound values.
+///
 /// This last parse method is necessary to evaluate compound types, i.e. types
 /// with values represented as {"K1":V1, ..., "KN":VN} or [V1, ..., VN].
 /// The following implementation is recommended. The parse(Ty &, Lexer &) method
@@ -663,6 +1380,40 @@ template<class Ty> struct Traits {
   typedef typename Ty::UnknownTraitsError ValueType;
 };
 
+namespace detail {
+/// Determines whether specified traits implement `bool validate(Lexer &)`.
+template<class TraitsTy, class = void>
+struct HasValidate : public std::false_type {};
+
+template<class TraitsTy>
+struct HasValidate<TraitsTy,
+    decltype(void(TraitsTy::validate(std::declval<Lexer &>())))> :
+  public std::true_type {};
+
+/// Checks a value with the help of the validate() method of specified traits.
+template<class TraitsTy, class Ty>
+inline bool validate(Lexer &Lex, std::true_type) {
+  return TraitsTy::validate(Lex);
+}
+
+/// Checks a value with the help of the parse() method of specified traits,
+/// the value is converted to a temporary object.
+template<class TraitsTy, class Ty>
+inline bool validate(Lexer &Lex, std::false_type) {
+  Ty Tmp;
+  return TraitsTy::parse(Tmp, Lex);
+}
+
+/// \brief Checks that a value which starts at the current token can be
+/// converted to Ty with the help of specified traits.
+///
+/// If TraitsTy does not implement validate() the value is parsed into
+/// a temporary object.
+template<class TraitsTy, class Ty> inline bool validate(Lexer &Lex) {
+  return validate<TraitsTy, Ty>(Lex, HasValidate<TraitsTy>());
+}
+}
+
 /// \brief This implements methods to convert value in a JSON string to
 /// specified cell in a static map.
 ///
@@ -678,6 +1429,9 @@ template<class CellKey> struct CellTraits {
         noexcept(Traits<ValueType>::parse(Dest, Lex))) {
     return Traits<ValueType>::parse(Dest, Lex);
   }
+  inline static bool validate(Lexer &Lex) {
+    return detail::validate<Traits<ValueType>, ValueType>(Lex);
+  }
   inline static void unparse(String &JSON, const ValueType &Obj)
       noexcept(
         noexcept(Traits<ValueType>::unparse(JSON, Obj))) {
@@ -702,22 +1456,47 @@ template<class... Objects> class Parser {
   /// \brief This parses a specified JSON string and converts it to
   /// a specified type.
   ///
-  /// There are two ways to use this functor. If a target type is known it is
-  /// possible to use static method parse(), otherwise this functor can be
-  /// passed to a bcl::TypeList::for_each() method. In the last case
-  /// bcl::TypeList should comprise different target types and appropriate type
-  /// will be determined by name. Note that in this case all target type must
-  /// propose a static `Object::ObjectName name()` method.
+  /// If a target type is known it is possible to use static method parse().
+  /// Otherwise, create() method can be used to build a map from
+  /// identifiers of objects to appropriate factories (see factories()).
+  /// Note that in this case all target type must propose a static
+  /// `Object::ObjectName name()` method.
   class ParseFunctor {
   public:
     /// Converts JSON string to a specified Ty.
     template<class Ty> static bool parse(Ty &Obj, Lexer &Lex) {
       Lex.resetPosition();
-      Lex.goToNext();
-      if (!Traits<Ty>::parse(Obj, Lex)) {
+      if (!Lex.goToNext() || !Traits<Ty>::parse(Obj, Lex)) {
         Lex.errors().insert(JSON_ERROR(6), Lex.start());
         return false;
       }
+      return checkEnd(Lex);
+    }
+
+    /// Checks that JSON string can be converted to a specified Ty.
+    template<class Ty> static bool validate(Lexer &Lex) {
+      Lex.resetPosition();
+      if (!Lex.goToNext() || !detail::validate<Traits<Ty>, Ty>(Lex)) {
+        Lex.errors().insert(JSON_ERROR(6), Lex.start());
+        return false;
+      }
+      return checkEnd(Lex);
+    }
+
+    /// \brief Creates an object of a specified type Ty and converts
+    /// JSON string to this object.
+    ///
+    /// \return Unique pointer to created object or nullptr.
+    template<class Ty> static std::unique_ptr<Object> create(Lexer &Lex) {
+      auto Obj = std::unique_ptr<Ty>(new Ty);
+      if (!parse(*Obj, Lex))
+        return nullptr;
+      return std::unique_ptr<Object>(std::move(Obj));
+    }
+
+  private:
+    /// Checks that there are no tokens after a converted value.
+    static bool checkEnd(Lexer &Lex) {
       if (Lex.next() < Lex.json().size()) {
         Lex.goToNext();
         Lex.checkSpecial(Token::COMMA);
@@ -725,31 +1504,43 @@ template<class... Objects> class Parser {
       }
       return true;
     }
+  };
 
-    /// Creates functor to convert JSON string to a type with a specified name.
-    ParseFunctor(Object::ObjectName Name, Lexer &Lex) :
-      mName(Name), mLex(Lex) {}
+  /// Function which creates an object of some known type from a JSON string.
+  typedef std::unique_ptr<Object>(*ObjectFactory)(Lexer &);
 
-    /// Converts JSON string to a specified Ty if it has an appropriate name.
-    template<class Ty> void operator()() {
-      if (Ty::name() != mName)
-        return;
-      auto Obj = std::unique_ptr<Ty>(new Ty);
-      if (!parse(*Obj, mLex))
-        return;
-      mObject = std::move(Obj);
-    }
+  /// Map from an identifier of a JSON object to a function which creates it.
+  typedef detail::NameTable<ObjectFactory> FactoryMap;
 
-    /// Returns unique pointer to created object or nullptr.
-    std::unique_ptr<Object> stealObject() noexcept {
-      return std::move(mObject);
-    }
+  /// \brief Returns a map from identifiers of supported JSON objects to
+  /// functions which create these objects.
+  ///
+  /// The map is built once on the first use, so the type of an object can
+  /// be determined with a single lookup. Identifiers are looked up directly
+  /// in a JSON string. If there are multiple objects with the same identifier
+  /// the first one in the list of supported objects is used.
+  static const FactoryMap & factories() {
+    static const FactoryMap Factories{
+      { Objects::name(), &ParseFunctor::template create<Objects> }... };
+    return Factories;
+  }
 
-  private:
-    Object::ObjectName mName;
-    Lexer &mLex;
-    std::unique_ptr<Object> mObject;
-  };
+  /// Function which checks that a JSON string represents an object of
+  /// some known type.
+  typedef bool(*ObjectValidator)(Lexer &);
+
+  /// Map from an identifier of a JSON object to a function which checks it.
+  typedef detail::NameTable<ObjectValidator> ValidatorMap;
+
+  /// \brief Returns a map from identifiers of supported JSON objects to
+  /// functions which check representation of these objects.
+  ///
+  /// \sa factories()
+  static const ValidatorMap & validators() {
+    static const ValidatorMap Validators{
+      { Objects::name(), &ParseFunctor::template validate<Objects> }... };
+    return Validators;
+  }
 
   /// \brief This unparses JSON object to a JSON string.
   ///
@@ -819,49 +1610,34 @@ public:
   /// errors can be found in Lex.errors() container.
   template<class CT, class Ty>
   static bool traverse(Ty &Dest, Lexer &Lex) {
-    Token Last;
-    if (Lex.is(Token::LEFT_BRACKET))
-      Last = Token::RIGHT_BRACKET;
-    else if (Lex.checkSpecial(Token::LEFT_BRACE))
-      Last = Token::RIGHT_BRACE;
-    else
-      return false;
-    Position Count = 0;
-    if (!Lex.goToNext())
-      return false;
-    // It may be empty container, so it is checked here.
-    // This is not the end of string so do not check that
-    // mLex.next() >= mLex.json().size().
-    if (Lex.is(Last))
-      return true;
-    for (;;) {
-      std::pair<Position, Position> Key(0, Count++);
-      if (Last == Token::RIGHT_BRACE) {
-        if (!Lex.checkIdentifier())
-          return false;
-        Key = std::make_pair(Lex.start(), Lex.end());
-        if (!Lex.goToNext() || !Lex.checkSpecial(Token::COLON) ||
-            !Lex.goToNext())
-          return false;
-      }
-      if (!Lex.is(Token::LEFT_BRACE) && !Lex.is(Token::LEFT_BRACKET) &&
-          !Lex.checkValue())
-        return false;
-      if (!CT::parse(Dest, Lex, Key))
-        return false;
-      if (!Lex.goToNext())
-        return false;
-      // This is not the end of string so do not check that
-      // mLex.next() >= mLex.json().size().
-      if (Lex.is(Last))
-        return true;
-      if (!Lex.checkSpecial(Token::COMMA))
-        return false;
-      if (!Lex.goToNext())
-        return false;
-    }
+    return traversePairs(Lex,
+      [&Dest, &Lex](std::pair<Position, Position> Key) {
+        return CT::parse(Dest, Lex, Key);
+      });
   }
 
+  /// \brief Traverses all pairs of keys and value in a string bounded with
+  /// left and right braces and checks values without conversion.
+  ///
+  /// This is a counterpart of traverse(Ty &, Lexer &) which should be used to
+  /// implement Traits::validate() methods. For each pair of keys and values
+  /// the method CT::validate(Lexer &, std::pair<Position, Position>) will
+  /// be called.
+  template<class CT> static bool traverse(Lexer &Lex) {
+    return traversePairs(Lex, [&Lex](std::pair<Position, Position> Key) {
+      return CT::validate(Lex, Key);
+    });
+  }
+
+  /// \brief Checks that a value which starts at the current token can be
+  /// converted to a specified type Ty.
+  ///
+  /// This is a utility method which should be used to implement
+  /// Traits::validate() methods. If Traits<Ty> does not implement validate()
+  /// the value is parsed into a temporary object.
+  template<class Ty> static bool validateValue(Lexer &Lex) {
+    return detail::validate<Traits<Ty>, Ty>(Lex);
+  }
   /// \brief Determines number of keys in array representation.
   ///
   /// This is a utility method.
@@ -873,6 +1649,17 @@ public:
   /// For empty arrays the second value in the tuple id undefined.
   static std::tuple<Position, Position, bool> numberOfKeys(Lexer &Lex);
 
+  /// \brief Returns number of elements (or name-value pairs) in a compound
+  /// value which starts at the current token.
+  ///
+  /// This is a utility method which can be used to reserve memory before
+  /// a compound value is parsed. Nested values and strings are not lexed, a
+  /// structural index (tape) is used if it is available. Note, that the
+  /// structure of the value is not checked, so the result is 0 if the current
+  /// token is neither '{' nor '[' or the value is not closed. The result
+  /// does not exceed the limit of number of elements (see Limits).
+  static Position numberOfElements(const Lexer &Lex);
+
   /// \brief Unparses a specified JSON object to a JSON string.
   ///
   /// NameKey parameter is a key for a field which marks JSON object identifier
@@ -915,15 +1702,49 @@ public:
     assert(NameKey && "Identifier of a JSON object must not be null!");
   }
 
+  /// \brief Constructs a lexer for a specified JSON string and attaches
+  /// a previously built structural index of this string.
+  ///
+  /// NameKey parameter is a key for a field which marks JSON object identifier
+  /// in a JSON string.
+  Parser(const String &JSON, std::shared_ptr<const Tape> T,
+      const char *NameKey = "name")
+    : mLex(JSON, std::move(T)), mNameKey(NameKey) {
+    assert(NameKey && "Identifier of a JSON object must not be null!");
+  }
+
+  /// \brief Builds a structural index of the JSON string.
+  ///
+  /// The index is reused by all subsequent calls of parse() methods, so
+  /// compound values which should be skipped are not re-scanned. The index
+  /// can be also shared with other parsers of the same string (see tape()).
+  /// \return False if the JSON string is malformed and the index has not been
+  /// built.
+  bool buildTape() { return mLex.buildTape(); }
+
+  /// Returns a structural index of the JSON string or nullptr.
+  const std::shared_ptr<const Tape> & tape() const noexcept {
+    return mLex.tape();
+  }
+
   /// Parses JSON string and returns appropriate JSON object or
   /// nullptr if errors have occurred.
   std::unique_ptr<Object> parse() {
-    if (!parseName())
+    if (!parseName(false))
       return nullptr;
-    ParseFunctor F(
-      mLex.json().substr(mNameStart + 1, mNameEnd - mNameStart - 1), mLex);
-    ObjectTypeList::for_each_type(F);
-    return F.stealObject();
+    return create();
+  }
+
+  /// \brief Parses JSON string which starts with an identifier of an object
+  /// and returns appropriate JSON object or nullptr if errors have occurred.
+  ///
+  /// The identifier must be the first key in the JSON string, so it is not
+  /// searched among other keys. Note, that unparse() always emits identifier
+  /// as the first key.
+  std::unique_ptr<Object> parseNameFirst() {
+    if (!parseName(true))
+      return nullptr;
+    return create();
   }
 
   /// Parses JSON string and converts it to a specified type,
@@ -932,25 +1753,116 @@ public:
     return ParseFunctor::parse(Obj, mLex);
   }
 
-  /// Key stored in a JSON string which marks identifier of an JSON object.
-  const char *getNameKey() noexcept {
-    return mNameKey;
+  /// \brief Checks that JSON string represents one of supported objects,
+  /// returns true on success.
+  ///
+  /// The type of an object is determined by its identifier as in parse(),
+  /// however, the object is not created. Errors are reported in the same
+  /// way as in parse().
+  bool validate() {
+    if (!parseName(false))
+      return false;
+    auto Validator = validators().find(
+      mLex.json().data() + mNameStart + 1, mNameEnd - mNameStart - 1);
+    return Validator && (*Validator)(mLex);
+  }
+
+  /// \brief Checks that JSON string can be converted to a specified type,
+  /// returns true on success.
+  ///
+  /// Objects of the specified type are not created if Traits implement
+  /// validate() methods.
+  template<class Ty> bool validate() {
+    return ParseFunctor::template validate<Ty>(mLex);
+  }
+
+  /// Key stored in a JSON string which marks identifier of an JSON object.
+  const char *getNameKey() noexcept {
+    return mNameKey;
+  }
+
+  /// Returns container of errors.
+  const bcl::Diagnostic & errors() const noexcept { return mLex.errors(); }
+
+  /// Returns true if errors have been occurred, internal errors are
+  /// also considered.
+  bool hasErrors() const { return mLex.hasErrors(); }
+
+  /// Returns statistics which have been collected during parsing.
+  Statistics statistics() const { return mLex.statistics(); }
+
+  /// Returns limits which are checked during parsing.
+  const Limits & limits() const noexcept { return mLex.limits(); }
+
+  /// Sets limits which are checked during parsing.
+  void setLimits(const Limits &L) noexcept { mLex.setLimits(L); }
+
+private:
+  /// \brief Traverses all pairs of keys and value in a string bounded with
+  /// left and right braces and invokes Process(Key) for each pair.
+  ///
+  /// \sa traverse(Ty &, Lexer &)
+  template<class Function>
+  static bool traversePairs(Lexer &Lex, Function &&Process) {
+    Token Last;
+    if (Lex.is(Token::LEFT_BRACKET))
+      Last = Token::RIGHT_BRACKET;
+    else if (Lex.checkSpecial(Token::LEFT_BRACE))
+      Last = Token::RIGHT_BRACE;
+    else
+      return false;
+    Position Count = 0;
+    if (!Lex.goToNext())
+      return false;
+    // It may be empty container, so it is checked here.
+    // This is not the end of string so do not check that
+    // mLex.next() >= mLex.json().size().
+    if (Lex.is(Last))
+      return true;
+    for (;;) {
+      std::pair<Position, Position> Key(0, Count++);
+      if (!Lex.checkElements(Count))
+        return false;
+      if (Last == Token::RIGHT_BRACE) {
+        if (!Lex.checkIdentifier())
+          return false;
+        Key = std::make_pair(Lex.start(), Lex.end());
+        if (!Lex.goToNext() || !Lex.checkSpecial(Token::COLON) ||
+            !Lex.goToNext())
+          return false;
+      }
+      if (!Lex.is(Token::LEFT_BRACE) && !Lex.is(Token::LEFT_BRACKET) &&
+          !Lex.checkValue())
+        return false;
+      if (!Process(Key))
+        return false;
+      if (!Lex.goToNext())
+        return false;
+      // This is not the end of string so do not check that
+      // mLex.next() >= mLex.json().size().
+      if (Lex.is(Last))
+        return true;
+      if (!Lex.checkSpecial(Token::COMMA))
+        return false;
+      if (!Lex.goToNext())
+        return false;
+    }
+  }
+
+  /// Creates an object which has been previously identified with parseName().
+  std::unique_ptr<Object> create() {
+    auto Factory = factories().find(
+      mLex.json().data() + mNameStart + 1, mNameEnd - mNameStart - 1);
+    return Factory ? (*Factory)(mLex) : nullptr;
   }
 
-  /// Returns container of errors.
-  const bcl::Diagnostic & errors() const noexcept { return mLex.errors(); }
-
-  /// Returns true if errors have been occurred, internal errors are
-  /// also considered.
-  bool hasErrors() const { return mLex.hasErrors(); }
-
-private:
   /// \brief Determines identifier to build appropriate JSONObject object.
   ///
+  /// If FirstOnly is true, the identifier is expected to be the first key.
   /// \post If this method returns true identifier is represented by characters
   /// in the range [mNameStart, mNameEnd].
   /// \return True in success, false if some errors have been occurred.
-  bool parseName() {
+  bool parseName(bool FirstOnly) {
     mLex.resetPosition();
     if (!mLex.goToNext() || !mLex.checkSpecial(Token::LEFT_BRACE))
       return false;
@@ -969,10 +1881,14 @@ private:
         mNameEnd = mLex.end();
         return true;
       }
-      if (((mLex.is(Token::LEFT_BRACE) || mLex.is(Token::LEFT_BRACKET)) &&
-           !mLex.skipInternal()) ||
-          !mLex.checkValue())
+      if (FirstOnly)
+        break;
+      if (mLex.is(Token::LEFT_BRACE) || mLex.is(Token::LEFT_BRACKET)) {
+        if (!mLex.skipInternal())
+          return false;
+      } else if (!mLex.checkValue()) {
         return false;
+      }
       if (!mLex.goToNext())
         return false;
       if (mLex.is(Token::RIGHT_BRACE) && mLex.next() < mLex.json().size())
@@ -990,15 +1906,97 @@ private:
   const char *mNameKey;
 };
 
+namespace detail {
+/// \brief Returns maximum number of elements in an array of pointers which
+/// is represented as {"0":V0, ..., "N":VN}.
+///
+/// Missed elements of such arrays are null and they are not represented in
+/// a JSON string. So, the number of elements is limited by the length of
+/// the representation to keep allocated memory proportional to the size
+/// of a JSON string.
+inline Position sparseSizeLimit(const Tape::Entry &E) noexcept {
+  return E.Close - E.Open;
+}
+
+/// \brief Determines number of elements in array representation and checks
+/// that there are no missed and duplicate indexes.
+///
+/// Array is represented using the following JSON strings:
+/// {"0":V0, ..., "N":VN} or [V0, ..., VN]. If AllowMissed is true missed
+/// indexes are not checked.
+/// \return True on success, errors can be found in Lex.errors() container.
+inline bool checkArrayKeys(Lexer &Lex, Position &Count,
+    bool AllowMissed = false) {
+  Position MaxIdx;
+  bool Ok;
+  std::tie(Count, MaxIdx, Ok) = Parser<>::numberOfKeys(Lex);
+  if (!Ok)
+    return false;
+  if (Count != 0) {
+    if (Count < MaxIdx + 1) {
+      /// User of JSON serializer can not determine if there is some
+      /// uninitialized elements in an array without manual parsing of
+      /// a JSON string. So do not parse such arrays. This array
+      /// should be parsed as a map.
+      auto *E = AllowMissed ? Lex.indexValue() : nullptr;
+      if (!E || MaxIdx >= sparseSizeLimit(*E)) {
+        Lex.errors().insert(JSON_ERROR(7), Lex.start());
+        return false;
+      }
+    } else if (Count > MaxIdx + 1) {
+      Lex.errors().insert(JSON_ERROR(8), Lex.start());
+      return false;
+    }
+  }
+  return true;
+}
+
+/// \brief Converts a key of a pair "Key":Value to an index of an element
+/// in an array.
+///
+/// The key is represented by characters in a range [Key.first, Key.second]
+/// of a JSON string including quotes. Only decimal digits are allowed
+/// between quotes and the key is not copied.
+/// \return False if the key is not an index or it is too large.
+inline bool parseIndex(const String &JSON, std::pair<Position, Position> Key,
+    Position &Idx) noexcept {
+  if (Key.second <= Key.first + 1)
+    return false;
+  Idx = 0;
+  for (auto I = Key.first + 1; I < Key.second; ++I) {
+    if (!std::isdigit(JSON[I]))
+      return false;
+    Position Digit = JSON[I] - '0';
+    if (Idx > (std::numeric_limits<Position>::max() - Digit) / 10)
+      return false;
+    Idx = Idx * 10 + Digit;
+  }
+  return true;
+}
+
+/// Checks that a key of a pair "Key":Value can be converted to KeyTy.
+template<class KeyTy>
+inline bool validateKey(Lexer &Lex, std::pair<Position, Position> Key) {
+  Lex.storePosition();
+  Lex.setPosition(Key.first);
+  bool Ok = Parser<>::validateValue<KeyTy>(Lex);
+  Lex.restorePosition();
+  return Ok;
+}
+}
+
 template<> struct Traits<std::string> {
   inline static String unescape(const String &Str) {
-    if (Str.size() < 2)
-      return Str;
     std::string Res;
-    Res.reserve(Str.length());
-    auto I = Str.begin(), EI = Str.end() - 1;
+    unescape(Str.data(), Str.data() + Str.size(), Res);
+    return Res;
+  }
+
+  /// Unescapes characters in a range [I, EI) and appends them to Res.
+  inline static void unescape(const char *I, const char *EI, String &Res) {
+    Res.reserve(Res.size() + (EI - I));
     while (I != EI) {
-      if (*I != '\\') {
+      if (*I != '\\' || I + 1 == EI) {
         Res += *I;
         ++I;
         continue;
@@ -1014,9 +2012,6 @@ template<> struct Traits<std::string> {
       }
       ++I;
     }
-    if (I == EI)
-      Res += Str.back();
-    return Res;
   }
   inline static Position escape(String &JSON, Position Pos) {
     switch (JSON[Pos]) {
@@ -1033,15 +2028,24 @@ template<> struct Traits<std::string> {
   }
   inline static bool parse(std::string &Dest, Lexer &Lex) noexcept {
     try {
+      // Characters are unescaped directly into the destination, so
+      // a temporary copy of the value is not created and memory which has
+      // been already allocated for the destination is reused.
       auto Value = Lex.discardQuote();
-      Dest = unescape(
-        Lex.json().substr(Value.first, Value.second - Value.first + 1));
+      JSON_STATISTIC(Lex, Allocations,
+        Value.second + 1 - Value.first > Dest.capacity());
+      Dest.clear();
+      unescape(Lex.json().data() + Value.first,
+        Lex.json().data() + Value.second + 1, Dest);
     }
     catch (...) {
       return false;
     }
     return true;
   }
+  inline static bool validate(Lexer &Lex) noexcept {
+    return !Lex.is(Token::LEFT_BRACE) && !Lex.is(Token::LEFT_BRACKET);
+  }
   inline static void unparse(String &JSON, const std::string &Obj) {
     auto I = JSON.size() + 1;
     JSON += '"' + Obj + '"';
@@ -1243,6 +2247,7 @@ template<> struct Traits<char *> {
 
             throw 0;
           }
+          JSON_STATISTIC(Lex, Allocations, 1);
           TmpDest = new char[MaxIdx + 1];
         }
         // Note, in case of empty array traverse also should be called to move
@@ -1257,8 +2262,10 @@ template<> struct Traits<char *> {
     } else {
       try {
         auto Value = Lex.discardQuote();
-        auto Unescaped = Traits<std::string>::unescape(
-          Lex.json().substr(Value.first, Value.second - Value.first + 1));
+        std::string Unescaped;
+        Traits<std::string>::unescape(Lex.json().data() + Value.first,
+          Lex.json().data() + Value.second + 1, Unescaped);
+        JSON_STATISTIC(Lex, Allocations, 1);
         TmpDest = new char[Unescaped.length() + 1];
         Unescaped.copy(TmpDest, Unescaped.length());
         TmpDest[Unescaped.length()] = '\0';
@@ -1284,6 +2291,16 @@ template<> struct Traits<char *> {
       return Traits<char>::parse(Dest[Key.second], Lex);
     }
   }
+  inline static bool validate(Lexer &Lex) {
+    if (!Lex.is(Token::LEFT_BRACE) && !Lex.is(Token::LEFT_BRACKET))
+      return true;
+    Position Count;
+    return detail::checkArrayKeys(Lex, Count) &&
+      Parser<>::traverse<Traits<char *>>(Lex);
+  }
+  inline static bool validate(Lexer &Lex, std::pair<Position, Position>) {
+    return Parser<>::validateValue<char>(Lex);
+  }
   inline static void unparse(String &JSON, const char *Obj) {
     if (!Obj)
       return;
@@ -1319,6 +2336,7 @@ template<class Ty> struct Traits<Ty *> {
 
             throw 0;
           }
+          JSON_STATISTIC(Lex, Allocations, 1);
           TmpDest = new Ty[MaxIdx + 1];
         }
         // Note, in case of empty array traverse also should be called to move
@@ -1333,6 +2351,7 @@ template<class Ty> struct Traits<Ty *> {
     } else {
       try {
         auto Value = Lex.discardQuote();
+        JSON_STATISTIC(Lex, Allocations, 1);
         TmpDest = new Ty;
         if (!Traits<Ty>::parse(*TmpDest, Lex))
           throw 0;
@@ -1358,6 +2377,16 @@ template<class Ty> struct Traits<Ty *> {
       return Traits<Ty>::parse(Dest[Key.second], Lex);
     }
   }
+  inline static bool validate(Lexer &Lex) {
+    if (!Lex.is(Token::LEFT_BRACE) && !Lex.is(Token::LEFT_BRACKET))
+      return Parser<>::validateValue<Ty>(Lex);
+    Position Count;
+    return detail::checkArrayKeys(Lex, Count) &&
+      Parser<>::traverse<Traits<Ty *>>(Lex);
+  }
+  inline static bool validate(Lexer &Lex, std::pair<Position, Position>) {
+    return Parser<>::validateValue<Ty>(Lex);
+  }
   inline static void unparse(String &JSON, const Ty* Obj) {
     if (Obj)
       Traits<Ty>::unparse(JSON, *Obj);
@@ -1373,6 +2402,9 @@ template<class Ty> struct Traits<const Ty *> {
     }
     return false;
   }
+  inline static bool validate(Lexer &Lex) {
+    return Traits<Ty *>::validate(Lex);
+  }
   inline static void unparse(String &JSON, const Ty* Obj) {
       Traits<Ty *>::unparse(JSON, Obj);
   }
@@ -1380,26 +2412,65 @@ template<class Ty> struct Traits<const Ty *> {
 
 template<class Ty, class Allocator>
 struct Traits<std::vector<Ty, Allocator>> {
-  inline static bool parse(std::vector<Ty, Allocator> &Dest, Lexer &Lex) {
-    Position MaxIdx, Count;
-    bool Ok;
-    std::tie(Count, MaxIdx, Ok) = Parser<>::numberOfKeys(Lex);
-    if (!Ok)
-      return false;
-    if (Count != 0) {
-      if (Count < MaxIdx + 1) {
-        /// User of JSON serializer can not determine if there is some
-        /// uninitialized elements in an array without manual parsing of
-        /// a JSON string. So do not parse such arrays. This array
-        /// should be parsed as a map.
-        Lex.errors().insert(JSON_ERROR(7), Lex.start());
+  /// \brief Array of elements which are specified in arbitrary order.
+  ///
+  /// Missed elements are allowed in arrays of pointers only,
+  /// such elements are null.
+  struct Sparse {
+    std::vector<Ty, Allocator> &Dest;
+    std::vector<bool> IsSet;
+    Position Open;
+    Position MaxSize;
+  };
+
+  /// This converts elements of a sparse array.
+  struct SparseTraits {
+    inline static bool parse(Sparse &S, Lexer &Lex,
+        std::pair<Position, Position> Key) {
+      Position Idx;
+      if (!detail::parseIndex(Lex.json(), Key, Idx))
         return false;
-      } else if (Count > MaxIdx + 1) {
-        Lex.errors().insert(JSON_ERROR(8), Lex.start());
+      if (Idx >= S.Dest.size()) {
+        // Memory for all elements of an array without missed elements has
+        // been already allocated. So, if an index is out of range some
+        // element is missed.
+        if (!std::is_pointer<Ty>::value || Idx >= S.MaxSize) {
+          /// User of JSON serializer can not determine if there is some
+          /// uninitialized elements in an array without manual parsing of
+          /// a JSON string. So do not parse such arrays. This array
+          /// should be parsed as a map. Arrays of pointers are limited
+          /// (see detail::sparseSizeLimit()).
+          Lex.errors().insert(JSON_ERROR(7), S.Open);
+          return false;
+        }
+        if (Idx >= Lex.limits().MaxElements) {
+          Lex.errors().insert(
+            JSON_ERROR(11), Key.first, Lex.limits().MaxElements);
+          return false;
+        }
+        JSON_STATISTIC(Lex, Allocations, Idx >= S.Dest.capacity());
+        S.Dest.resize(Idx + 1);
+        S.IsSet.resize(Idx + 1);
+      } else if (S.IsSet[Idx]) {
+        Lex.errors().insert(JSON_ERROR(8), Key.first);
         return false;
       }
+      S.IsSet[Idx] = true;
+      return Traits<Ty>::parse(S.Dest[Idx], Lex);
     }
-    Dest.resize(Count);
+  };
+
+  inline static bool parse(std::vector<Ty, Allocator> &Dest, Lexer &Lex) {
+    if (Lex.is(Token::LEFT_BRACE))
+      return parseSparse(Dest, Lex);
+    Position Count;
+    if (!detail::checkArrayKeys(Lex, Count))
+      return false;
+    // Elements of [V0, ..., VN] are appended in order, so they are not
+    // constructed before conversion.
+    JSON_STATISTIC(Lex, Allocations, Count > Dest.capacity());
+    Dest.clear();
+    Dest.reserve(Count);
     // Note, in case of empty array traverse also should be called to move
     // lexer position to the end of this array.
     return Parser<>::
@@ -1407,16 +2478,69 @@ struct Traits<std::vector<Ty, Allocator>> {
   }
   inline static bool parse(std::vector<Ty, Allocator> &Dest, Lexer &Lex,
       std::pair<Position, Position> Key) {
-    if (Key.first != 0) {
-      // Note that Idx will be successfully converted because this check has
-      // been performed when memory for the Dest array has been allocated.
-      // This also implies that Dest[Idx] can not produce out of range exception.
-      auto Idx = std::stoull(
-        Lex.json().substr(Key.first + 1, Key.second - Key.first - 1));
-      return Traits<Ty>::parse(Dest[Idx], Lex);
-    } else {
-      return Traits<Ty>::parse(Dest[Key.second], Lex);
+    assert(Key.first == 0 && Key.second == Dest.size() &&
+      "Elements of an array must be appended in order!");
+    return append(Dest, Lex, std::is_trivially_default_constructible<Ty>());
+  }
+  /// \brief Converts {"0":V0, ..., "N":VN} to an array in a single pass.
+  ///
+  /// Elements may be specified in arbitrary order, each index is converted
+  /// once. Keys are not pre-scanned, the number of elements is obtained
+  /// from the structural index of the value (see Lexer::indexValue()).
+  /// Indexes of N elements must be in a range [0, N) unless elements are
+  /// pointers, so the memory is allocated at once and a missed element is
+  /// reported as soon as an index out of this range is found. Indexes of
+  /// pointers are limited by detail::sparseSizeLimit().
+  inline static bool parseSparse(std::vector<Ty, Allocator> &Dest,
+      Lexer &Lex) {
+    auto *E = Lex.indexValue();
+    if (!E) {
+      Lex.errors().insert(JSON_ERROR(1), Lex.json().size());
+      return false;
+    }
+    if (!Lex.checkElements(E->Size))
+      return false;
+    Sparse S{ Dest, std::vector<bool>(), Lex.start(),
+              detail::sparseSizeLimit(*E) };
+    Dest.clear();
+    if (!std::is_pointer<Ty>::value) {
+      JSON_STATISTIC(Lex, Allocations, E->Size > Dest.capacity());
+      Dest.resize(E->Size);
+      S.IsSet.resize(E->Size);
+    }
+    return Parser<>::traverse<SparseTraits>(S, Lex);
+  }
+  /// Converts a value to a trivial type and appends it to the array, so
+  /// the element is not initialized twice.
+  inline static bool append(std::vector<Ty, Allocator> &Dest, Lexer &Lex,
+      std::true_type) {
+    Ty Value;
+    if (!Traits<Ty>::parse(Value, Lex))
+      return false;
+    Dest.push_back(Value);
+    return true;
+  }
+  /// \brief Creates a new element at the end of the array and converts
+  /// a value in place, so the element is not moved or copied.
+  ///
+  /// Note, that the element is default constructed before conversion
+  /// because Traits<Ty>::parse() converts a value to an existing object.
+  inline static bool append(std::vector<Ty, Allocator> &Dest, Lexer &Lex,
+      std::false_type) {
+    Dest.emplace_back();
+    if (!Traits<Ty>::parse(Dest.back(), Lex)) {
+      Dest.pop_back();
+      return false;
     }
+    return true;
+  }
+  inline static bool validate(Lexer &Lex) {
+    Position Count;
+    return detail::checkArrayKeys(Lex, Count, std::is_pointer<Ty>::value) &&
+      Parser<>::traverse<Traits<std::vector<Ty, Allocator>>>(Lex);
+  }
+  inline static bool validate(Lexer &Lex, std::pair<Position, Position>) {
+    return Parser<>::validateValue<Ty>(Lex);
   }
   inline static void unparse(String &JSON,
       const std::vector<Ty, Allocator> &Obj) {
@@ -1467,6 +2591,13 @@ struct Traits<std::set<KeyTy, Compare, Allocator>> {
     KeyTy KeyValue;
     if (!Traits<KeyTy>::parse(KeyValue, Lex))
       return false;
+    JSON_STATISTIC(Lex, Allocations, 1);
+    // Elements are unparsed in sorted order, so in most cases a new element
+    // should be inserted at the end of the set in amortized constant time.
+    if (Dest.empty() || Dest.key_comp()(*Dest.rbegin(), KeyValue)) {
+      Dest.emplace_hint(Dest.end(), std::move(KeyValue));
+      return true;
+    }
     auto Pair = Dest.insert(std::move(KeyValue));
     if (!Pair.second) {
       Lex.errors().insert(JSON_ERROR(8), Lex.start());
@@ -1474,6 +2605,14 @@ struct Traits<std::set<KeyTy, Compare, Allocator>> {
     }
     return true;
   }
+  inline static bool validate(Lexer &Lex) {
+    if (!Lex.checkSpecial(Token::LEFT_BRACKET))
+      return false;
+    return Parser<>::traverse<Traits<SetTy>>(Lex);
+  }
+  inline static bool validate(Lexer &Lex, std::pair<Position, Position>) {
+    return Parser<>::validateValue<KeyTy>(Lex);
+  }
   inline static void unparse(String &JSON, const SetTy &Obj) {
     JSON += '[';
     if (!Obj.empty()) {
@@ -1508,17 +2647,35 @@ struct Traits<std::map<KeyTy, Ty, Compare, Allocator>> {
     KeyTy KeyValue;
     Traits<KeyTy>::parse(KeyValue, Lex);
     Lex.restorePosition();
-    auto Pair = Dest.emplace(KeyValue, Ty());
-    if (!Pair.second) {
-      Lex.errors().insert(JSON_ERROR(8), Lex.start());
-      return false;
+    JSON_STATISTIC(Lex, Allocations, 1);
+    typename MapTy::iterator I;
+    // Keys are unparsed in sorted order, so in most cases a new element
+    // should be inserted at the end of the map in amortized constant time.
+    if (Dest.empty() || Dest.key_comp()(Dest.rbegin()->first, KeyValue)) {
+      I = Dest.emplace_hint(Dest.end(), std::piecewise_construct,
+        std::forward_as_tuple(std::move(KeyValue)), std::tuple<>());
+    } else {
+      auto Pair = Dest.emplace(std::piecewise_construct,
+        std::forward_as_tuple(std::move(KeyValue)), std::tuple<>());
+      if (!Pair.second) {
+        Lex.errors().insert(JSON_ERROR(8), Lex.start());
+        return false;
+      }
+      I = Pair.first;
     }
-    if (!Traits<Ty>::parse(Pair.first->second, Lex)) {
-      Dest.erase(Pair.first);
+    if (!Traits<Ty>::parse(I->second, Lex)) {
+      Dest.erase(I);
       return false;
     }
     return true;
   }
+  inline static bool validate(Lexer &Lex) {
+    return Parser<>::traverse<Traits<MapTy>>(Lex);
+  }
+  inline static bool validate(Lexer &Lex, std::pair<Position, Position> Key) {
+    return detail::validateKey<KeyTy>(Lex, Key) &&
+      Parser<>::validateValue<Ty>(Lex);
+  }
   inline static void unparse(String &JSON, const MapTy &Obj) {
     JSON += '{';
     if (!Obj.empty()) {
@@ -1561,7 +2718,17 @@ struct Traits<std::multimap<KeyTy, Ty, Compare, Allocator>> {
     KeyTy KeyValue;
     Traits<KeyTy>::parse(KeyValue, Lex);
     Lex.restorePosition();
-    auto Itr = Dest.emplace(KeyValue, Ty());
+    JSON_STATISTIC(Lex, Allocations, 1);
+    // Keys are unparsed in sorted order, so in most cases a new element
+    // should be inserted at the end of the map in amortized constant time.
+    // Note, that the end of the map is also a position of a new element
+    // if its key is equal to the last one.
+    auto Itr =
+      Dest.empty() || !Dest.key_comp()(KeyValue, Dest.rbegin()->first) ?
+        Dest.emplace_hint(Dest.end(), std::piecewise_construct,
+          std::forward_as_tuple(std::move(KeyValue)), std::tuple<>()) :
+        Dest.emplace(std::piecewise_construct,
+          std::forward_as_tuple(std::move(KeyValue)), std::tuple<>());
     if (Itr == Dest.end())
       return false;
     if (!Traits<Ty>::parse(Itr->second, Lex)) {
@@ -1570,6 +2737,13 @@ struct Traits<std::multimap<KeyTy, Ty, Compare, Allocator>> {
     }
     return true;
   }
+  inline static bool validate(Lexer &Lex) {
+    return Parser<>::traverse<Traits<MapTy>>(Lex);
+  }
+  inline static bool validate(Lexer &Lex, std::pair<Position, Position> Key) {
+    return detail::validateKey<KeyTy>(Lex, Key) &&
+      Parser<>::validateValue<Ty>(Lex);
+  }
   inline static void unparse(String &JSON, const MapTy &Obj) {
     JSON += '{';
     if (!Obj.empty()) {
@@ -1599,6 +2773,102 @@ struct Traits<std::multimap<KeyTy, Ty, Compare, Allocator>> {
   }
 };
 
+template<class KeyTy, class Hash, class KeyEqual, class Allocator>
+struct Traits<std::unordered_set<KeyTy, Hash, KeyEqual, Allocator>> {
+  typedef std::unordered_set<KeyTy, Hash, KeyEqual, Allocator> SetTy;
+  inline static bool parse(SetTy &Dest, Lexer &Lex) {
+    if (!Lex.checkSpecial(Token::LEFT_BRACKET))
+      return false;
+    Dest.reserve(Dest.size() + Parser<>::numberOfElements(Lex));
+    return Parser<>::traverse<Traits<SetTy>>(Dest, Lex);
+  }
+  inline static bool parse(SetTy &Dest, Lexer &Lex,
+      std::pair<Position, Position> Key) {
+    KeyTy KeyValue;
+    if (!Traits<KeyTy>::parse(KeyValue, Lex))
+      return false;
+    JSON_STATISTIC(Lex, Allocations, 1);
+    auto Pair = Dest.insert(std::move(KeyValue));
+    if (!Pair.second) {
+      Lex.errors().insert(JSON_ERROR(8), Lex.start());
+      return false;
+    }
+    return true;
+  }
+  inline static bool validate(Lexer &Lex) {
+    if (!Lex.checkSpecial(Token::LEFT_BRACKET))
+      return false;
+    return Parser<>::traverse<Traits<SetTy>>(Lex);
+  }
+  inline static bool validate(Lexer &Lex, std::pair<Position, Position>) {
+    return Parser<>::validateValue<KeyTy>(Lex);
+  }
+  inline static void unparse(String &JSON, const SetTy &Obj) {
+    JSON += '[';
+    for (auto &K : Obj) {
+      String Key;
+      Traits<KeyTy>::unparse(Key, K);
+      if (!Key.empty())
+        JSON += Key + ',';
+    }
+    if (JSON.back() == ',')
+      JSON.erase(JSON.size() - 1);
+    JSON += ']';
+  }
+};
+
+template<class KeyTy, class Ty, class Hash, class KeyEqual, class Allocator>
+struct Traits<std::unordered_map<KeyTy, Ty, Hash, KeyEqual, Allocator>> {
+  typedef std::unordered_map<KeyTy, Ty, Hash, KeyEqual, Allocator> MapTy;
+  inline static bool parse(MapTy &Dest, Lexer &Lex) {
+    Dest.reserve(Dest.size() + Parser<>::numberOfElements(Lex));
+    return Parser<>::traverse<Traits<MapTy>>(Dest, Lex);
+  }
+  inline static bool parse(MapTy &Dest, Lexer &Lex,
+      std::pair<Position, Position> Key) {
+    Lex.storePosition();
+    Lex.setPosition(Key.first);
+    KeyTy KeyValue;
+    Traits<KeyTy>::parse(KeyValue, Lex);
+    Lex.restorePosition();
+    JSON_STATISTIC(Lex, Allocations, 1);
+    auto Pair = Dest.emplace(std::piecewise_construct,
+      std::forward_as_tuple(std::move(KeyValue)), std::tuple<>());
+    if (!Pair.second) {
+      Lex.errors().insert(JSON_ERROR(8), Lex.start());
+      return false;
+    }
+    if (!Traits<Ty>::parse(Pair.first->second, Lex)) {
+      Dest.erase(Pair.first);
+      return false;
+    }
+    return true;
+  }
+  inline static bool validate(Lexer &Lex) {
+    return Parser<>::traverse<Traits<MapTy>>(Lex);
+  }
+  inline static bool validate(Lexer &Lex, std::pair<Position, Position> Key) {
+    return detail::validateKey<KeyTy>(Lex, Key) &&
+      Parser<>::validateValue<Ty>(Lex);
+  }
+  inline static void unparse(String &JSON, const MapTy &Obj) {
+    JSON += '{';
+    for (auto &KV : Obj) {
+      String Value;
+      Traits<typename MapTy::mapped_type>::unparse(Value, KV.second);
+      if (Value.empty())
+        continue;
+      String Id;
+      Traits<typename MapTy::key_type>::unparse(Id, KV.first);
+      Id = bcl::quote(std::move(Id));
+      JSON += Id + ':' + Value + ',';
+    }
+    if (JSON.back() == ',')
+      JSON.erase(JSON.size() - 1);
+    JSON += '}';
+  }
+};
+
 namespace detail {
 /// This functor parses a value which starts with the last token extracted
 /// from a JSON string, converts it to an appropriate type and assigns
@@ -1611,7 +2881,7 @@ public:
   /// The Key parameter is necessary to identify destination which should be set
   /// on the parsed value.
   ParseCellFunctor(std::pair<Position, Position> Key, Lexer &Lex) : mLex(Lex),
-    mKey(Key), mHasError(false) {}
+    mKey(Key), mHasError(false), mIsMatched(false) {}
 
   /// \brief Parses a value specified by the last token evaluated by the
   /// lexer, converts it to an appropriate type and assigns to a currently
@@ -1625,16 +2895,59 @@ public:
           mKey.first + 1, mKey.second - mKey.first - 1 ,
           CellTraits<CellKey>::name()) != 0)
       return;
+    mIsMatched = true;
     mHasError = !CellTraits<CellKey>::parse(
       Cell->template value<CellKey>(), mLex);
   }
 
   /// Returns true if errors have been occurred during conversion.
   bool hasError() const noexcept { return mHasError; }
+
+  /// Returns true if a cell associated with the key has been found.
+  bool isMatched() const noexcept { return mIsMatched; }
+private:
+  Lexer &mLex;
+  std::pair<Position, Position> mKey;
+  bool mHasError;
+  bool mIsMatched;
+};
+
+/// This functor checks a value which starts with the last token extracted
+/// from a JSON string without conversion. It should be called for each key
+/// of a JSON object implemented as a bcl::StaticMap.
+class ValidateCellFunctor {
+public:
+  /// \brief Creates this functor to check a value associated with
+  /// a specified key.
+  ValidateCellFunctor(std::pair<Position, Position> Key, Lexer &Lex) :
+    mLex(Lex), mKey(Key), mHasError(false), mIsMatched(false) {}
+
+  /// \brief Checks a value specified by the last token evaluated by the
+  /// lexer if the currently evaluated key is a key of a specified cell.
+  ///
+  /// If CellTraits for this cell do not implement validate() method, the value
+  /// is parsed into a temporary object.
+  template<class CellTy> void operator()() {
+    typedef typename CellTy::CellKey CellKey;
+    if (mIsMatched || mLex.json().compare(
+          mKey.first + 1, mKey.second - mKey.first - 1 ,
+          CellTraits<CellKey>::name()) != 0)
+      return;
+    mIsMatched = true;
+    mHasError = !validate<CellTraits<CellKey>, typename CellKey::ValueType>(
+      mLex);
+  }
+
+  /// Returns true if errors have been occurred.
+  bool hasError() const noexcept { return mHasError; }
+
+  /// Returns true if a cell associated with the key has been found.
+  bool isMatched() const noexcept { return mIsMatched; }
 private:
   Lexer &mLex;
   std::pair<Position, Position> mKey;
   bool mHasError;
+  bool mIsMatched;
 };
 
 /// This functor unparses JSON object represented as a bcl::StaticMap. It should
@@ -1679,8 +2992,29 @@ template<class... Args> struct Traits<bcl::StaticMap<Args...>> {
       std::pair<Position, Position> Key) {
     detail::ParseCellFunctor Parse(Key, Lex);
     Dest.for_each(Parse);
+    if (!Parse.isMatched())
+      return skipUnknown(Lex);
     return !Parse.hasError();
   }
+  inline static bool validate(Lexer &Lex) {
+    if (!Lex.checkSpecial(Token::LEFT_BRACE))
+      return false;
+    return Parser<>::traverse<Traits<bcl::StaticMap<Args...>>>(Lex);
+  }
+  inline static bool validate(Lexer &Lex, std::pair<Position, Position> Key) {
+    detail::ValidateCellFunctor Validate(Key, Lex);
+    bcl::StaticMap<Args...>::for_each_key(Validate);
+    if (!Validate.isMatched())
+      return skipUnknown(Lex);
+    return !Validate.hasError();
+  }
+  /// Skips a value of an unknown key, so the lexer points to the last
+  /// token of this value.
+  inline static bool skipUnknown(Lexer &Lex) {
+    if (Lex.is(Token::LEFT_BRACE) || Lex.is(Token::LEFT_BRACKET))
+      return Lex.skipInternal();
+    return true;
+  }
   inline static void unparse(String &JSON, const bcl::StaticMap<Args...> &Obj) {
     detail::UnparseCellFunctor Unparse(JSON);
     JSON += '{';
@@ -1691,7 +3025,6 @@ template<class... Args> struct Traits<bcl::StaticMap<Args...>> {
 
 template<class... Objects> std::tuple<Position, Position, bool>
 Parser<Objects...>::numberOfKeys(Lexer &Lex) {
-  Lex.storePosition();
   Position MaxIdx = 0;
   Position Count = 0;
   Token Last;
@@ -1701,6 +3034,14 @@ Parser<Objects...>::numberOfKeys(Lexer &Lex) {
     Last = Token::RIGHT_BRACE;
   else
     return std::make_tuple(0, 0, false);
+  if (Last == Token::RIGHT_BRACKET)
+    if (auto *E = Lex.indexValue()) {
+      if (!Lex.checkElements(E->Size))
+        return std::make_tuple(0, 0, false);
+      return std::make_tuple(E->Size, E->Size > 0 ? E->Size - 1 : 0, true);
+    }
+  JSON_STATISTIC(Lex, KeyScans, 1);
+  Lex.storePosition();
   if (!Lex.goToNext())
     return std::make_tuple(0, 0, false);
   if (Lex.is(Last)) {
@@ -1709,13 +3050,23 @@ Parser<Objects...>::numberOfKeys(Lexer &Lex) {
   }
   for (;;) {
     ++Count;
+    if (!Lex.checkElements(Count))
+      return std::make_tuple(0, 0, false);
     if (Last == Token::RIGHT_BRACE) {
       if (!Lex.checkIdentifier())
         return std::make_tuple(0, 0, false);
-      unsigned long long Idx;
-      if (!Traits<unsigned long long>::parse(Idx, Lex))
+      Position Idx;
+      if (!detail::parseIndex(
+            Lex.json(), std::make_pair(Lex.start(), Lex.end()), Idx))
+        return std::make_tuple(0, 0, false);
+      // Memory for all elements up to Idx is going to be allocated, so
+      // the index is limited in the same way as number of elements.
+      if (Idx >= Lex.limits().MaxElements) {
+        Lex.errors().insert(
+          JSON_ERROR(11), Lex.start(), Lex.limits().MaxElements);
         return std::make_tuple(0, 0, false);
-      MaxIdx = static_cast<Position>(Idx > MaxIdx ? Idx : MaxIdx);
+      }
+      MaxIdx = Idx > MaxIdx ? Idx : MaxIdx;
       if (!Lex.goToNext() || !Lex.checkSpecial(Token::COLON) ||
           !Lex.goToNext())
         return std::make_tuple(0, 0, false);
@@ -1740,11 +3091,63 @@ Parser<Objects...>::numberOfKeys(Lexer &Lex) {
     Count, Last == Token::RIGHT_BRACE ? MaxIdx : Count - 1, true);
 }
 
+template<class... Objects>
+Position Parser<Objects...>::numberOfElements(const Lexer &Lex) {
+  if (!Lex.is(Token::LEFT_BRACE) && !Lex.is(Token::LEFT_BRACKET))
+    return 0;
+  if (auto *E = Lex.findInTape(Lex.start()))
+    return std::min(E->Size, Lex.limits().MaxElements);
+  int Level = 0;
+  Position Commas = 0;
+  detail::StructuralScanner Scanner(Lex.json(), true);
+  auto Close = Scanner.scan(Lex.next(), [&Level, &Commas](char Ch, Position) {
+    switch (Ch) {
+    case static_cast<char>(Token::COMMA):
+      if (Level == 0)
+        ++Commas;
+      return true;
+    case static_cast<char>(Token::LEFT_BRACE):
+    case static_cast<char>(Token::LEFT_BRACKET):
+      ++Level;
+      return true;
+    default:
+      return Level-- != 0;
+    }
+  });
+  if (Close == Lex.json().size())
+    return 0;
+  auto I = Lex.next();
+  for (; I < Close && std::isspace(Lex.json()[I]); ++I);
+  return I == Close ? 0 : std::min(Commas + 1, Lex.limits().MaxElements);
+}
+
 template<> struct Traits<bcl::Diagnostic> {
   inline static bool parse(bcl::Diagnostic &Dest, Lexer &Lex) {
     return Parser<>::
       traverse<Traits<bcl::Diagnostic>>(Dest, Lex);
   }
+  inline static bool validate(Lexer &Lex) {
+    return Parser<>::traverse<Traits<bcl::Diagnostic>>(Lex);
+  }
+  /// Splits a message into a kind, a code, a position and a text, Kind and
+  /// Buf must be large enough to store the whole message.
+  inline static bool scan(const char *Msg, char *Kind, std::size_t &Code,
+      std::uintmax_t &Pos, char *Buf) {
+    return std::sscanf(Msg, "%s C%zu(%ju): %s", Kind, &Code, &Pos, Buf) == 4;
+  }
+  inline static bool validate(Lexer &Lex, std::pair<Position, Position>) {
+    std::string Msg;
+    if (!Lex.checkIdentifier() || !Traits<std::string>::parse(Msg, Lex))
+      return false;
+    std::vector<char> Kind(Msg.size() + 1), Buf(Msg.size() + 1);
+    std::size_t Code;
+    std::uintmax_t Pos;
+    if (!scan(Msg.c_str(), Kind.data(), Code, Pos, Buf.data())) {
+      Lex.errors().insert(JSON_ERROR(9), Lex.start());
+      return false;
+    }
+    return true;
+  }
   inline static bool parse(bcl::Diagnostic &Dest, Lexer &Lex,
     std::pair<Position, Position>) {
     const char *Msg;
@@ -1754,8 +3157,8 @@ template<> struct Traits<bcl::Diagnostic> {
     char *Buf = new char[std::strlen(Msg) + 1];
     std::size_t Code;
     std::uintmax_t Pos;
-    auto ArgNum = std::sscanf(Msg, "%s C%zu(%ju): %s", Kind, &Code, &Pos, Buf);
-    if (ArgNum != 4 || std::strcmp(Kind, Dest.getKind()) != 0 ||
+    if (!scan(Msg, Kind, Code, Pos, Buf) ||
+        std::strcmp(Kind, Dest.getKind()) != 0 ||
         !Dest.insert(Code, "%s", Pos, Buf)) {
       Lex.errors().insert(JSON_ERROR(9), Lex.start());
       delete[]Kind;
@@ -1782,7 +3185,61 @@ template<> struct Traits<bcl::Diagnostic> {
 };
 }
 
+/// \brief Explicitly instantiates templates for frequently used types.
+///
+/// Extern_ is either `extern` to declare instantiations or empty to define
+/// them. Instantiations are defined in the BCLJson library. Targets which
+/// link this library get BCL_JSON_EXTERN_TEMPLATES definition, so these
+/// templates are not instantiated in each translation unit.
+#define JSON_INSTANTIATE_TEMPLATES(Extern_) \
+  Extern_ template class Parser<>; \
+  JSON_INSTANTIATE_ROOT(Extern_, int) \
+  JSON_INSTANTIATE_ROOT(Extern_, long) \
+  JSON_INSTANTIATE_ROOT(Extern_, long long) \
+  JSON_INSTANTIATE_ROOT(Extern_, unsigned) \
+  JSON_INSTANTIATE_ROOT(Extern_, unsigned long) \
+  JSON_INSTANTIATE_ROOT(Extern_, unsigned long long) \
+  JSON_INSTANTIATE_ROOT(Extern_, float) \
+  JSON_INSTANTIATE_ROOT(Extern_, double) \
+  JSON_INSTANTIATE_ROOT(Extern_, bool) \
+  JSON_INSTANTIATE_ROOT(Extern_, std::string) \
+  JSON_INSTANTIATE_VECTOR(Extern_, int) \
+  JSON_INSTANTIATE_VECTOR(Extern_, long) \
+  JSON_INSTANTIATE_VECTOR(Extern_, long long) \
+  JSON_INSTANTIATE_VECTOR(Extern_, unsigned) \
+  JSON_INSTANTIATE_VECTOR(Extern_, unsigned long) \
+  JSON_INSTANTIATE_VECTOR(Extern_, unsigned long long) \
+  JSON_INSTANTIATE_VECTOR(Extern_, float) \
+  JSON_INSTANTIATE_VECTOR(Extern_, double) \
+  JSON_INSTANTIATE_VECTOR(Extern_, std::string) \
+  JSON_INSTANTIATE_ROOT(Extern_, bcl::Diagnostic) \
+  JSON_INSTANTIATE_TRAVERSE(Extern_, bcl::Diagnostic)
+
+/// Instantiates conversion of a JSON string to a specified type.
+#define JSON_INSTANTIATE_ROOT(Extern_, Type_) \
+  Extern_ template bool Parser<>::parse<Type_>(Type_ &);
+
+/// Instantiates traversal of a compound value of a specified type.
+#define JSON_INSTANTIATE_TRAVERSE(Extern_, Type_) \
+  Extern_ template bool Parser<>::traverse<Traits<Type_>, Type_>( \
+    Type_ &, Lexer &); \
+  Extern_ template bool Parser<>::traverse<Traits<Type_>>(Lexer &);
+
+/// Instantiates conversion of std::vector with a specified type of elements.
+#define JSON_INSTANTIATE_VECTOR(Extern_, Type_) \
+  Extern_ template struct Traits<std::vector<Type_>>; \
+  JSON_INSTANTIATE_ROOT(Extern_, std::vector<Type_>) \
+  JSON_INSTANTIATE_TRAVERSE(Extern_, std::vector<Type_>)
+
+#ifdef BCL_JSON_EXTERN_TEMPLATES
+namespace json {
+JSON_INSTANTIATE_TEMPLATES(extern)
+}
+#endif
+
 //===- Definition of macros which simplifies definition of a JSON-object --===//
+#ifndef BCL_JSON_NO_OBJECT_MACROS
 #include "JsonObjectMacros.h"
+#endif
 
 #endif// TSAR_REQUESTS_H
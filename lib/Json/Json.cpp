@@ -0,0 +1,32 @@
+//===--- Json.cpp ------- JSON Templates Instantiation ---------*- C++ -*-===//
+//
+//                       Base Construction Library (BCL)
+//
+// Copyright 2018 Nikita Kataev
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file explicitly instantiates JSON parser templates for frequently used
+// types (scalars, strings, vectors of them and bcl::Diagnostic). Users of this
+// library declare these instantiations as extern (see
+// JSON_INSTANTIATE_TEMPLATES in bcl/Json.h), so they are compiled once.
+//
+//===----------------------------------------------------------------------===//
+
+#include <bcl/Json.h>
+
+namespace json {
+JSON_INSTANTIATE_TEMPLATES()
+}
@@ -22,34 +22,107 @@
 // to listen incoming connections from clients. This network server relies on
 // createServer() from bcl/Socket.h to process client's requests.
 // Multiple clinets can be connected at the same time.
-// A separate thread is used to maintain each connection.
+// A separate thread is used to maintain each connection by default. It is also
+// possible to multiplex all connections in a few event loops.
 //
 //===----------------------------------------------------------------------===//
 
 #include <bcl/CSocket.h>
 #include <bcl/utility.h>
+#include <algorithm>
+#include <atomic>
 #include <cassert>
-#include <csignal>
-#include <chrono>
-#include <future>
+#include <cerrno>
+#include <climits>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <limits>
+#include <mutex>
 #include <string>
+#include <system_error>
 #include <thread>
 #include <vector>
 #include <unordered_map>
+#include <unordered_set>
 
 #if _WIN32
 # include <ws2tcpip.h>
 # include <winsock2.h>
 #else
 # include <arpa/inet.h>
+# include <fcntl.h>
 # include <sys/socket.h>
+# include <sys/stat.h>
+# include <sys/uio.h>
+# include <sys/un.h>
 # include <netdb.h>
 # include <netinet/in.h>
+# include <netinet/tcp.h>
+# include <poll.h>
 # include <unistd.h>
+# ifdef __linux__
+#  include <pthread.h>
+#  include <sched.h>
+#  include <sys/epoll.h>
+# endif
 #endif
 
 using namespace bcl;
 
+namespace {
+/// Reference to a contiguous sequence of bytes which should be sent.
+struct DataRef {
+  const char *Data;
+  std::size_t Size;
+};
+
+/// Prefix of addresses of Unix domain sockets.
+constexpr char UnixPrefix[] = "unix:";
+constexpr std::size_t UnixPrefixSize = sizeof(UnixPrefix) - 1;
+}
+
+/// Returns true if a specified address is an address of Unix domain socket.
+static inline bool isUnixAddress(const net::AddressT &Address) {
+  return Address.compare(0, UnixPrefixSize, UnixPrefix) == 0;
+}
+
+/// Converts a socket address to a printable address and a port number.
+static inline std::pair<net::AddressT, net::PortT>
+toAddress(const sockaddr_storage &Address) {
+  char Buffer[INET6_ADDRSTRLEN];
+  switch (Address.ss_family) {
+  case AF_INET: {
+    auto &Inet = reinterpret_cast<const sockaddr_in &>(Address);
+    if (!inet_ntop(AF_INET, &Inet.sin_addr, Buffer, sizeof(Buffer)))
+      break;
+    return std::make_pair(net::AddressT(Buffer), ntohs(Inet.sin_port));
+  }
+  case AF_INET6: {
+    auto &Inet6 = reinterpret_cast<const sockaddr_in6 &>(Address);
+    // IPv4 clients of a dual-stack socket are reported with IPv4 addresses.
+    if (IN6_IS_ADDR_V4MAPPED(&Inet6.sin6_addr)) {
+      if (!inet_ntop(AF_INET, Inet6.sin6_addr.s6_addr + 12,
+                     Buffer, sizeof(Buffer)))
+        break;
+    } else if (!inet_ntop(AF_INET6, &Inet6.sin6_addr, Buffer,
+                          sizeof(Buffer))) {
+      break;
+    }
+    return std::make_pair(net::AddressT(Buffer), ntohs(Inet6.sin6_port));
+  }
+#ifndef _WIN32
+  case AF_UNIX: {
+    auto &Unix = reinterpret_cast<const sockaddr_un &>(Address);
+    return std::make_pair(UnixPrefix + net::AddressT(Unix.sun_path), 0);
+  }
+#endif
+  default:
+    break;
+  }
+  return std::make_pair(net::AddressT(), 0);
+}
+
 #ifdef _WIN32
 using SocketT = SOCKET;
 
@@ -72,8 +145,13 @@ static inline bool closeSocket(SocketT S) {
   return closesocket(S) != SOCKET_ERROR;
 }
 
+static inline void shutdownSocket(SocketT S) { shutdown(S, SD_BOTH); }
+
 static inline bool getAddressInfo(int Domain, int Type, int Protocol,
     const net::AddressT &Address, net::PortT PortNo, AddressInfoT &Result) {
+  // Unix domain sockets are not supported on Windows.
+  if (isUnixAddress(Address))
+    return false;
   addrinfo Hints;
   std::memset(&Hints, 0, sizeof(Hints));
   Hints.ai_family = Domain;
@@ -87,6 +165,10 @@ static inline bool getAddressInfo(int Domain, int Type, int Protocol,
              : false;
 }
 
+static inline int getDomain(const AddressInfoT &AddressInfo) {
+  return AddressInfo.Address->ai_family;
+}
+
 static inline std::pair<SocketT, bool>
 createSocket(const AddressInfoT &AddressInfo) {
   auto S =
@@ -108,8 +190,31 @@ static inline bool bindSocket(SocketT S, const AddressInfoT &AddressInfo) {
               (int)AddressInfo.Address->ai_addrlen) != SOCKET_ERROR;
 }
 
-static inline bool sendData(SocketT S, const std::string &Message) {
-  return send(S, Message.c_str(), Message.length(), 0) != SOCKET_ERROR;
+static inline bool sendData(SocketT S, const DataRef *Data,
+    std::size_t Count, std::size_t *SentSize = nullptr) {
+  if (SentSize)
+    *SentSize = 0;
+  for (std::size_t I = 0; I < Count; ++I)
+    for (std::size_t ChunkSize = 0; ChunkSize < Data[I].Size;) {
+      auto Size = send(S, Data[I].Data + ChunkSize,
+        static_cast<int>(std::min<std::size_t>(Data[I].Size - ChunkSize,
+          std::numeric_limits<int>::max())), 0);
+      if (Size == SOCKET_ERROR)
+        return false;
+      ChunkSize += Size;
+      if (SentSize)
+        *SentSize += Size;
+    }
+  return true;
+}
+
+static inline void disableSigPipe(SocketT) noexcept {}
+
+/// Waits until a socket becomes writable, a negative timeout (in
+/// milliseconds) means an infinite timeout.
+static inline bool waitWritable(SocketT S, int Timeout) {
+  WSAPOLLFD Event{S, POLLWRNORM, 0};
+  return WSAPoll(&Event, 1, Timeout) != SOCKET_ERROR;
 }
 
 static inline std::pair<std::size_t, bool> receiveData(SocketT S,
@@ -126,7 +231,8 @@ struct AddressInfoT {
   int Domain;
   int Type;
   int Protocol;
-  sockaddr_in Address;
+  sockaddr_storage Address;
+  socklen_t AddressLength;
 };
 
 static inline bool initialize() noexcept { return true; }
@@ -134,26 +240,63 @@ static inline void finalize() noexcept {}
 
 static inline bool closeSocket(SocketT S) { return close(S) >= 0; }
 
+static inline void shutdownSocket(SocketT S) { shutdown(S, SHUT_RDWR); }
+
 static inline bool getAddressInfo(int Domain, int Type, int Protocol,
     const net::AddressT &Address, net::PortT PortNo,
     AddressInfoT &Result) noexcept {
   Result.Domain = Domain;
   Result.Type = Type;
   Result.Protocol = Protocol;
-  Result.Address.sin_family = AF_INET;
-  Result.Address.sin_port = htons(PortNo);
-  if (Address.empty()) {
-    Result.Address.sin_addr.s_addr = INADDR_ANY;
-  } else {
-    auto Host = gethostbyname(Address.c_str());
-    if (!Host)
+  std::memset(&Result.Address, 0, sizeof(Result.Address));
+  if (isUnixAddress(Address)) {
+    auto &Unix = reinterpret_cast<sockaddr_un &>(Result.Address);
+    auto PathSize = Address.size() - UnixPrefixSize;
+    if (PathSize == 0 || PathSize >= sizeof(Unix.sun_path))
       return false;
-    memmove(&Result.Address.sin_addr.s_addr,
-      Host->h_addr_list[0], Host->h_length);
+    Result.Domain = AF_UNIX;
+    Unix.sun_family = AF_UNIX;
+    std::memcpy(Unix.sun_path, Address.c_str() + UnixPrefixSize, PathSize);
+    Result.AddressLength = sizeof(Unix);
+    return true;
   }
+  addrinfo Hints;
+  std::memset(&Hints, 0, sizeof(Hints));
+  Hints.ai_family = Domain;
+  Hints.ai_socktype = Type;
+  Hints.ai_protocol = Protocol;
+  Hints.ai_flags = AI_PASSIVE;
+  addrinfo *List = nullptr;
+  if (getaddrinfo(!Address.empty() ? Address.c_str() : nullptr,
+                  std::to_string(PortNo).c_str(), &Hints, &List) != 0)
+    return false;
+  auto Info = List;
+  // Prefer the IPv6 wildcard address if IPv6 is available, because
+  // a dual-stack socket accepts IPv4 connections as well.
+  if (Address.empty())
+    for (auto I = List; I; I = I->ai_next) {
+      if (I->ai_family != AF_INET6)
+        continue;
+      auto S = socket(AF_INET6, I->ai_socktype, I->ai_protocol);
+      if (S >= 0) {
+        close(S);
+        Info = I;
+      }
+      break;
+    }
+  Result.Domain = Info->ai_family;
+  Result.Type = Info->ai_socktype;
+  Result.Protocol = Info->ai_protocol;
+  std::memcpy(&Result.Address, Info->ai_addr, Info->ai_addrlen);
+  Result.AddressLength = Info->ai_addrlen;
+  freeaddrinfo(List);
   return true;
 }
 
+static inline int getDomain(const AddressInfoT &AddressInfo) {
+  return AddressInfo.Domain;
+}
+
 static inline std::pair<SocketT, bool>
 createSocket(const AddressInfoT &AddressInfo) {
   auto SocketFD =
@@ -167,13 +310,134 @@ static inline bool setSocketOptions(SocketT S) {
   return setsockopt(S, SOL_SOCKET, SO_REUSEADDR, &Opt, sizeof(Opt)) >= 0;
 }
 
+/// Allows multiple sockets to listen the same address, returns false if
+/// the system does not distribute connections among such sockets.
+static inline bool setReusePort(SocketT S) {
+  int Opt = 1;
+#if defined(SO_REUSEPORT_LB)
+  return setsockopt(S, SOL_SOCKET, SO_REUSEPORT_LB, &Opt, sizeof(Opt)) >= 0;
+#elif defined(__linux__) && defined(SO_REUSEPORT)
+  return setsockopt(S, SOL_SOCKET, SO_REUSEPORT, &Opt, sizeof(Opt)) >= 0;
+#else
+  (void)S, (void)Opt;
+  return false;
+#endif
+}
+
+/// Binds a thread to the I-th (modulo the number of cores) CPU core which
+/// is available to the process.
+static inline void pinThread(std::thread &T, std::size_t I) {
+#ifdef __linux__
+  cpu_set_t Available;
+  if (sched_getaffinity(0, sizeof(Available), &Available) != 0)
+    return;
+  auto CoreNumber = CPU_COUNT(&Available);
+  if (CoreNumber <= 0)
+    return;
+  I %= CoreNumber;
+  for (int Core = 0; Core < CPU_SETSIZE; ++Core)
+    if (CPU_ISSET(Core, &Available) && I-- == 0) {
+      cpu_set_t Set;
+      CPU_ZERO(&Set);
+      CPU_SET(Core, &Set);
+      pthread_setaffinity_np(T.native_handle(), sizeof(Set), &Set);
+      return;
+    }
+#else
+  (void)T, (void)I;
+#endif
+}
+
 static inline bool bindSocket(SocketT S, const AddressInfoT &AddressInfo) {
-  return bind(S, (sockaddr *)&AddressInfo.Address,
-              sizeof(AddressInfo.Address)) >= 0;
+  if (AddressInfo.Domain == AF_UNIX) {
+    // Remove a socket file which may remain after a previous server.
+    auto &Unix = reinterpret_cast<const sockaddr_un &>(AddressInfo.Address);
+    struct stat Info;
+    if (stat(Unix.sun_path, &Info) == 0 && S_ISSOCK(Info.st_mode))
+      unlink(Unix.sun_path);
+  }
+  return bind(S, (const sockaddr *)&AddressInfo.Address,
+              AddressInfo.AddressLength) >= 0;
+}
+
+#ifndef MSG_NOSIGNAL
+# define MSG_NOSIGNAL 0
+#endif
+
+/// Waits until a socket becomes writable, a negative timeout (in
+/// milliseconds) means an infinite timeout.
+static inline bool waitWritable(SocketT S, int Timeout) {
+  pollfd Event{S, POLLOUT, 0};
+  return poll(&Event, 1, Timeout) >= 0 || errno == EINTR;
 }
 
-static inline bool sendData(SocketT S, const std::string &Message) {
-  return send(S, Message.c_str(), Message.length(), 0) >= 0;
+#ifndef IOV_MAX
+# define IOV_MAX 16
+#endif
+
+/// \brief Sends specified chunks of data, a single system call is used to
+/// send multiple chunks.
+///
+/// If SentSize is not null, this does not wait until a non-blocking socket
+/// becomes writable and the number of sent bytes is stored in SentSize.
+/// Otherwise, all data are sent.
+static inline bool sendData(SocketT S, const DataRef *Data,
+    std::size_t Count, std::size_t *SentSize = nullptr) {
+  if (SentSize)
+    *SentSize = 0;
+  std::vector<iovec> Chunks(Count);
+  for (std::size_t I = 0; I < Count; ++I) {
+    Chunks[I].iov_base = const_cast<char *>(Data[I].Data);
+    Chunks[I].iov_len = Data[I].Size;
+  }
+  std::size_t First = 0;
+  while (First < Count) {
+    if (Chunks[First].iov_len == 0) {
+      ++First;
+      continue;
+    }
+    msghdr Message;
+    std::memset(&Message, 0, sizeof(Message));
+    Message.msg_iov = &Chunks[First];
+    Message.msg_iovlen = std::min<std::size_t>(Count - First, IOV_MAX);
+    auto Size = sendmsg(S, &Message, MSG_NOSIGNAL);
+    if (Size >= 0) {
+      if (SentSize)
+        *SentSize += Size;
+      // Skip sent data, the last chunk may be sent partially.
+      for (std::size_t SentSize = Size; SentSize > 0;) {
+        auto ChunkSize = std::min(SentSize, Chunks[First].iov_len);
+        Chunks[First].iov_base =
+          static_cast<char *>(Chunks[First].iov_base) + ChunkSize;
+        Chunks[First].iov_len -= ChunkSize;
+        SentSize -= ChunkSize;
+        if (Chunks[First].iov_len == 0)
+          ++First;
+      }
+      continue;
+    }
+    if (errno == EINTR)
+      continue;
+    if (errno != EAGAIN && errno != EWOULDBLOCK)
+      return false;
+    if (SentSize)
+      return true;
+    // Socket is non-blocking (see ServerMode::EventLoop), so wait until it
+    // becomes writable.
+    if (!waitWritable(S, -1))
+      return false;
+  }
+  return true;
+}
+
+/// Disables SIGPIPE on systems which do not support MSG_NOSIGNAL.
+static inline void disableSigPipe(SocketT S) noexcept {
+#ifdef SO_NOSIGPIPE
+  int Opt = 1;
+  setsockopt(S, SOL_SOCKET, SO_NOSIGPIPE, &Opt, sizeof(Opt));
+#else
+  (void)S;
+#endif
 }
 
 static inline std::pair<std::size_t, bool> receiveData(SocketT S,
@@ -183,69 +447,843 @@ static inline std::pair<std::size_t, bool> receiveData(SocketT S,
     return std::make_pair(0, false);
   return std::make_pair(ReceivedSize, true);
 }
+
+static inline bool setNonBlocking(SocketT S) {
+  auto Flags = fcntl(S, F_GETFL, 0);
+  return Flags >= 0 && fcntl(S, F_SETFL, Flags | O_NONBLOCK) >= 0;
+}
 #endif
 
+/// Waits until data can be received from a socket or the connection is
+/// closed, received data are not consumed.
+static inline void waitData(SocketT S) {
+  char Byte;
+  recv(S, &Byte, 1, MSG_PEEK);
+}
+
+/// Allows an IPv6 socket to accept IPv4 connections as well.
+static inline bool setDualStack(SocketT S) {
+  int Opt = 0;
+  return setsockopt(S, IPPROTO_IPV6, IPV6_V6ONLY,
+                    reinterpret_cast<const char *>(&Opt), sizeof(Opt)) == 0;
+}
+
+/// Sets sizes of kernel buffers of a socket, accepted connections inherit
+/// them from a listening socket.
+static inline bool setBufferSizes(SocketT S,
+    const net::ServerOptions &Options) {
+  auto set = [S](int Name, int Size) {
+    return Size <= 0 || setsockopt(S, SOL_SOCKET, Name,
+      reinterpret_cast<const char *>(&Size), sizeof(Size)) == 0;
+  };
+  return set(SO_RCVBUF, Options.ReceiveBufferSize) &&
+         set(SO_SNDBUF, Options.SendBufferSize);
+}
+
+/// Sets options of an accepted TCP connection.
+static inline bool setTcpOptions(SocketT S,
+    const net::ServerOptions &Options) {
+  auto set = [S](int Level, int Name, int Value) {
+    return setsockopt(S, Level, Name,
+      reinterpret_cast<const char *>(&Value), sizeof(Value)) == 0;
+  };
+  if (Options.IsNoDelay && !set(IPPROTO_TCP, TCP_NODELAY, 1))
+    return false;
+  if (!Options.IsKeepAlive)
+    return true;
+  if (!set(SOL_SOCKET, SO_KEEPALIVE, 1))
+    return false;
+  // Parameters of probes are not changed if the system does not allow
+  // to set them for a separate socket.
+#if defined(TCP_KEEPIDLE)
+  if (Options.KeepAliveIdle > 0 &&
+      !set(IPPROTO_TCP, TCP_KEEPIDLE, Options.KeepAliveIdle))
+    return false;
+#elif defined(TCP_KEEPALIVE)
+  if (Options.KeepAliveIdle > 0 &&
+      !set(IPPROTO_TCP, TCP_KEEPALIVE, Options.KeepAliveIdle))
+    return false;
+#endif
+#ifdef TCP_KEEPINTVL
+  if (Options.KeepAliveInterval > 0 &&
+      !set(IPPROTO_TCP, TCP_KEEPINTVL, Options.KeepAliveInterval))
+    return false;
+#endif
+#ifdef TCP_KEEPCNT
+  if (Options.KeepAliveCount > 0 &&
+      !set(IPPROTO_TCP, TCP_KEEPCNT, Options.KeepAliveCount))
+    return false;
+#endif
+  return true;
+}
+
 namespace {
-class SocketImp: public bcl::Socket<std::string> {
+/// \brief Fixed number of threads which execute tasks.
+///
+/// Tasks which are submitted to the same strand are executed one by one in
+/// the order of their submission. Tasks from different strands may be
+/// executed concurrently.
+class WorkerPool : private bcl::Uncopyable {
+public:
+  /// Sequence of tasks which must not be executed concurrently.
+  class Strand : private bcl::Uncopyable {
+    friend class WorkerPool;
+    std::mutex mMutex;
+    std::deque<std::function<void()>> mTasks;
+    bool mIsScheduled = false;
+  };
+
+  explicit WorkerPool(std::size_t WorkerNumber) {
+    for (std::size_t I = 0; I < WorkerNumber; ++I)
+      mWorkers.emplace_back(&WorkerPool::work, this);
+  }
+
+  ~WorkerPool() {
+    {
+      std::lock_guard<std::mutex> Lock(mMutex);
+      mIsStopped = true;
+    }
+    mReady.notify_all();
+    for (auto &W : mWorkers)
+      W.join();
+  }
+
+  /// \brief Submits a task to a specified strand.
+  ///
+  /// The strand must not be destroyed until all its tasks are executed.
+  void submit(Strand &S, std::function<void()> Task) {
+    {
+      std::lock_guard<std::mutex> Lock(S.mMutex);
+      S.mTasks.push_back(std::move(Task));
+      if (S.mIsScheduled)
+        return;
+      S.mIsScheduled = true;
+    }
+    {
+      std::lock_guard<std::mutex> Lock(mMutex);
+      mQueue.push_back(&S);
+    }
+    mReady.notify_one();
+  }
+
+private:
+  void work() {
+    for (;;) {
+      Strand *S;
+      {
+        std::unique_lock<std::mutex> Lock(mMutex);
+        mReady.wait(Lock, [this]() { return mIsStopped || !mQueue.empty(); });
+        if (mQueue.empty())
+          return;
+        S = mQueue.front();
+        mQueue.pop_front();
+      }
+      // The last executed task is destroyed after the strand is unlocked,
+      // because it may own the strand.
+      std::function<void()> Task;
+      for (;;) {
+        {
+          std::lock_guard<std::mutex> Lock(S->mMutex);
+          if (S->mTasks.empty()) {
+            S->mIsScheduled = false;
+            break;
+          }
+          Task = std::move(S->mTasks.front());
+          S->mTasks.pop_front();
+        }
+        Task();
+      }
+    }
+  }
+
+  std::vector<std::thread> mWorkers;
+  std::mutex mMutex;
+  std::condition_variable mReady;
+  std::deque<Strand *> mQueue;
+  bool mIsStopped = false;
+};
+
+/// Storage for received data.
+struct Buffer {
+  std::unique_ptr<char[]> Data;
+  std::size_t Capacity = 0;
+};
+
+/// \brief Pool of buffers which are shared between connections.
+///
+/// A buffer is returned to the pool when its last owner is destroyed.
+class BufferPool : public std::enable_shared_from_this<BufferPool>,
+    private bcl::Uncopyable {
+public:
+  /// Creates a pool which retains at most MaxNumber free buffers with
+  /// capacity not greater than MaxCapacity.
+  BufferPool(std::size_t MaxNumber, std::size_t MaxCapacity)
+    : mMaxNumber(MaxNumber), mMaxCapacity(MaxCapacity) {}
+
+  /// Returns a buffer which can store at least Capacity bytes.
+  std::shared_ptr<Buffer> get(std::size_t Capacity) {
+    std::unique_ptr<Buffer> B;
+    {
+      std::lock_guard<std::mutex> Lock(mMutex);
+      if (!mFree.empty()) {
+        B = std::move(mFree.back());
+        mFree.pop_back();
+      }
+    }
+    if (!B)
+      B = bcl::make_unique<Buffer>();
+    if (B->Capacity < Capacity) {
+      B->Data = bcl::make_unique<char[]>(Capacity);
+      B->Capacity = Capacity;
+    }
+    std::weak_ptr<BufferPool> Pool = shared_from_this();
+    return std::shared_ptr<Buffer>(B.release(), [Pool](Buffer *B) {
+      std::unique_ptr<Buffer> Owned(B);
+      if (auto P = Pool.lock())
+        P->put(std::move(Owned));
+    });
+  }
+
+private:
+  void put(std::unique_ptr<Buffer> B) {
+    if (B->Capacity > mMaxCapacity)
+      return;
+    std::lock_guard<std::mutex> Lock(mMutex);
+    if (mFree.size() < mMaxNumber)
+      mFree.push_back(std::move(B));
+  }
+
+  std::size_t mMaxNumber;
+  std::size_t mMaxCapacity;
+  std::mutex mMutex;
+  std::vector<std::unique_ptr<Buffer>> mFree;
+};
+
+/// \brief This accumulates received bytes and splits them into messages.
+///
+/// Data are received directly into a buffer from a pool, and messages are
+/// passed to listeners as views into this buffer. The buffer is returned to
+/// the pool when all received data are processed. If some listener takes
+/// ownership of a message, the rest of data is moved to a new buffer when
+/// more space is needed, otherwise processed bytes are discarded by moving
+/// the rest of data to the beginning of the buffer. So, each message is
+/// a contiguous sequence of bytes.
+class MessageBuffer : private bcl::Uncopyable {
+  /// Size of a message length in the LengthPrefix framing mode.
+  static constexpr std::size_t PrefixSize = 4;
+public:
+  MessageBuffer(const bcl::net::ServerOptions &Options,
+      const std::shared_ptr<BufferPool> &Pool)
+    : mPool(Pool)
+    , mFraming(Options.Framing)
+    , mDelimiter(Options.Delimiter)
+    , mMaxMessageSize(Options.MaxMessageSize == 0 ?
+        std::numeric_limits<std::size_t>::max() : Options.MaxMessageSize) {
+    assert((mFraming != bcl::net::FramingMode::Delimiter ||
+      !mDelimiter.empty()) && "Delimiter must not be empty!");
+  }
+
+  /// Returns storage to receive at most Size bytes.
+  char *prepare(std::size_t Size) {
+    auto Pending = mEnd - mBegin;
+    if (!mOwner) {
+      setStorage(mPool->get(Size));
+    } else if (mEnd + Size > mStorage->Capacity) {
+      if (mOwner.use_count() == 1 && Pending + Size <= mStorage->Capacity) {
+        std::memmove(mStorage->Data.get(),
+          mStorage->Data.get() + mBegin, Pending);
+      } else {
+        auto Storage = mPool->get(std::max(Pending + Size,
+          mOwner.use_count() == 1 ? 2 * mStorage->Capacity : 0));
+        std::memcpy(Storage->Data.get(),
+          mStorage->Data.get() + mBegin, Pending);
+        setStorage(std::move(Storage));
+      }
+      // The search position is not advanced unless delimiters are used.
+      mSearchFrom = mSearchFrom > mBegin ? mSearchFrom - mBegin : 0;
+      mBegin = 0;
+      mEnd = Pending;
+    }
+    return mStorage->Data.get() + mEnd;
+  }
+
+  /// Marks Size bytes after the end of data as received.
+  void commit(std::size_t Size) {
+    assert(mOwner && mEnd + Size <= mStorage->Capacity &&
+      "Storage must be prepared!");
+    mEnd += Size;
+  }
+
+  /// Returns the owner of a buffer which contains extracted messages.
+  const std::shared_ptr<const void> &owner() const noexcept { return mOwner; }
+
+  /// \brief Extracts the next complete message.
+  ///
+  /// If framing is disabled, all available data are extracted.
+  /// \return False if there is no complete message or if the size of the
+  /// next message exceeds the limit (see isBroken()).
+  bool next(const char *&Message, std::size_t &Size) {
+    if (mIsBroken || mBegin == mEnd)
+      return false;
+    auto Data = mStorage->Data.get();
+    auto Available = mEnd - mBegin;
+    if (mFraming == bcl::net::FramingMode::None) {
+      Message = Data + mBegin;
+      Size = Available;
+      mBegin = mEnd;
+    } else if (mFraming == bcl::net::FramingMode::LengthPrefix) {
+      if (Available < PrefixSize)
+        return false;
+      std::size_t Length = 0;
+      for (std::size_t I = 0; I < PrefixSize; ++I)
+        Length = (Length << 8) | static_cast<unsigned char>(Data[mBegin + I]);
+      if (Length > mMaxMessageSize) {
+        mIsBroken = true;
+        return false;
+      }
+      if (Available - PrefixSize < Length)
+        return false;
+      Message = Data + mBegin + PrefixSize;
+      Size = Length;
+      mBegin += PrefixSize + Length;
+    } else {
+      // Do not rescan bytes which have been already checked.
+      auto From = std::max(mSearchFrom, mBegin);
+      auto I = std::search(Data + From, Data + mEnd,
+        mDelimiter.begin(), mDelimiter.end());
+      if (I == Data + mEnd) {
+        // The tail of data may contain a prefix of the delimiter.
+        if (mEnd - From >= mDelimiter.size())
+          mSearchFrom = mEnd - mDelimiter.size() + 1;
+        // The message contains at least Available - Delimiter.size() + 1
+        // bytes.
+        if (Available > mMaxMessageSize &&
+            Available - mMaxMessageSize >= mDelimiter.size())
+          mIsBroken = true;
+        return false;
+      }
+      auto End = static_cast<std::size_t>(I - Data);
+      if (End - mBegin > mMaxMessageSize) {
+        mIsBroken = true;
+        return false;
+      }
+      Message = Data + mBegin;
+      Size = End - mBegin;
+      mBegin = mSearchFrom = End + mDelimiter.size();
+    }
+    return true;
+  }
+
+  /// Returns the buffer to the pool if all received data are processed.
+  void release() {
+    if (mBegin != mEnd)
+      return;
+    mOwner.reset();
+    mStorage = nullptr;
+    mBegin = mEnd = mSearchFrom = 0;
+  }
+
+  /// Returns true if the size of a received message exceeds the limit.
+  bool isBroken() const noexcept { return mIsBroken; }
+
+  /// Returns true if no storage is held, so there are no pending data.
+  bool empty() const noexcept { return !mOwner; }
+
+private:
+  void setStorage(std::shared_ptr<Buffer> Storage) {
+    mStorage = Storage.get();
+    mOwner = std::move(Storage);
+  }
+
+  std::shared_ptr<BufferPool> mPool;
+  bcl::net::FramingMode mFraming;
+  std::string mDelimiter;
+  std::size_t mMaxMessageSize;
+  std::shared_ptr<const void> mOwner;
+  Buffer *mStorage = nullptr;
+  std::size_t mBegin = 0;
+  std::size_t mEnd = 0;
+  std::size_t mSearchFrom = 0;
+  bool mIsBroken = false;
+};
+
+/// \brief Adds a length prefix or a delimiter to a message which should be
+/// sent.
+///
+/// The Prefix buffer is used to store a length of the message.
+/// \return False if the message is too large to be sent.
+static bool frameMessage(const bcl::net::ServerOptions &Options,
+    const std::string &Message, char (&Prefix)[4],
+    std::vector<DataRef> &Result) {
+  switch (Options.Framing) {
+  case bcl::net::FramingMode::LengthPrefix:
+    if (Message.size() > 0xFFFFFFFFu)
+      return false;
+    for (std::size_t I = 0; I < sizeof(Prefix); ++I)
+      Prefix[I] = static_cast<char>(
+        Message.size() >> (sizeof(Prefix) - I - 1) * 8);
+    Result.push_back({Prefix, sizeof(Prefix)});
+    Result.push_back({Message.data(), Message.size()});
+    return true;
+  case bcl::net::FramingMode::Delimiter:
+    Result.push_back({Message.data(), Message.size()});
+    Result.push_back({Options.Delimiter.data(), Options.Delimiter.size()});
+    return true;
+  default:
+    Result.push_back({Message.data(), Message.size()});
+    return true;
+  }
+}
+
+class SocketImp: public bcl::net::ViewSocket,
+    public std::enable_shared_from_this<SocketImp> {
   enum class State : uint8_t {
     Open,
     OnClose,
     Closed,
   };
 public:
-  SocketImp(SocketT ConnectionFD, bcl::net::Connection &Connection,
-      std::size_t BufferSize, const bcl::net::SocketStatusHandler &on)
+  /// Creates a socket for an established connection. If a worker pool is
+  /// specified, createServer() and all listeners are executed in this pool.
+  SocketImp(SocketT ConnectionFD, const bcl::net::Connection &Connection,
+      const bcl::net::ServerOptions &Options,
+      const bcl::net::SocketStatusHandler &on,
+      const std::shared_ptr<BufferPool> &Buffers, WorkerPool *Pool = nullptr)
      : mConnectionFD(ConnectionFD)
      , mConnection(Connection)
-     , mBufferSize(BufferSize)
-     , mOn(on) {}
+     , mOptions(Options)
+     , mOn(on)
+     , mPool(Pool)
+     , mInput(Options, Buffers) {}
 
+  /// \brief Sends a message.
+  ///
+  /// If batching is enabled (see ServerOptions::BatchSize), small messages
+  /// which are sent from listeners are queued and sent together when all
+  /// listeners of a received message return. Otherwise, the message is sent
+  /// immediately. In the asynchronous mode, data which cannot be
+  /// written without blocking remain in the output buffer and an event loop
+  /// writes them later. Messages are ignored if the socket is closing.
   void send(const std::string &Message) const override {
-    if (!sendData(mConnectionFD, Message)) {
+    if (mState != State::Open)
+      return;
+    char Prefix[4];
+    std::vector<DataRef> Chunks;
+    if (!frameMessage(mOptions, Message, Prefix, Chunks)) {
       mOn(bcl::net::SocketStatus::SendError, mConnection);
       mState = State::OnClose;
-    } else {
-      mOn(bcl::net::SocketStatus::Send, mConnection);
+      return;
+    }
+    SendResult Result;
+    {
+      std::unique_lock<std::mutex> Lock(mOutputMutex);
+      if (isAsync())
+        enqueue(Lock, Chunks, Result);
+      else if (mBatchDepth == 0 ||
+               mOutputSize + sizeOf(Chunks) > mOptions.BatchSize)
+        flush(std::move(Chunks), Result);
+      else
+        push(Chunks);
     }
+    report(Result);
   }
 
   void receive(const ReceiveCallback &F) const override {
     mReceiveCallbacks.push_back(F);
   }
 
+  void receiveView(const ReceiveViewCallback &F) const override {
+    mReceiveViewCallbacks.push_back(F);
+  }
+
   void closed(const ClosedCallback &F) const override {
     mClosedCallbacks.push_back(F);
   }
 
-  int run() {
-    bcl::createServer(this);
-    auto Buffer = bcl::make_unique<char[]>(mBufferSize + 1);
+  /// Sets a function which initializes listeners of this socket instead of
+  /// createServer().
+  void setCreate(std::function<void(const bcl::net::ViewSocket *)> F) {
+    mCreate = std::move(F);
+  }
+
+  /// \brief Shuts down the connection if it is not closed yet.
+  ///
+  /// A thread which receives data is notified, so the socket is closed.
+  void shutdown() const {
+    std::lock_guard<std::mutex> Lock(mCloseMutex);
+    if (mState != State::Closed)
+      shutdownSocket(mConnectionFD);
+  }
+
+  /// Invokes createServer() to initialize listeners of this socket.
+  void start() {
+    execute([this]() {
+      beginBatch();
+      if (mCreate)
+        mCreate(this);
+      else
+        bcl::createServer(this);
+      endBatch();
+    });
+  }
+
+  /// Returns storage to receive the next chunk of data, its size is equal
+  /// to the BufferSize option.
+  char *prepare() { return mInput.prepare(mOptions.BufferSize); }
+
+  /// Returns storage to the pool if there is no incomplete message, it
+  /// should be called if data are not received into prepared storage.
+  void unprepare() { mInput.release(); }
+
+  /// \brief Passes a received chunk of data to listeners.
+  ///
+  /// The data must be received into storage which is returned by prepare().
+  /// If framing is enabled, only complete messages are passed to listeners
+  /// and the rest of data is stored until the next chunk is received.
+  /// \return False if the socket should be closed. If listeners are executed
+  /// in a worker pool, the socket is shut down when some error occurs later,
+  /// so a thread which receives data is notified.
+  bool process(std::size_t Size) {
+    mInput.commit(Size);
+    mOn(bcl::net::SocketStatus::Receive, mConnection);
+    const char *Message;
+    std::size_t MessageSize;
+    while (mState != State::OnClose && mInput.next(Message, MessageSize))
+      deliver(Message, MessageSize);
+    if (mInput.isBroken()) {
+      mOn(bcl::net::SocketStatus::ReceiveError, mConnection);
+      return false;
+    }
+    mInput.release();
+    return mState != State::OnClose;
+  }
+
+  /// \brief Closes the socket and notifies listeners.
+  ///
+  /// If a worker pool is used, the socket is closed after all previously
+  /// received data are processed. Done is invoked when the socket is closed.
+  void close(bool IsOk, const std::function<void()> &Done = nullptr) {
+    execute([this, IsOk, Done]() {
+      closeSocket(IsOk);
+      if (Done)
+        Done();
+    });
+  }
+
+  /// \brief Receives data and passes them to listeners until the socket is
+  /// closed.
+  ///
+  /// Done is invoked when the socket is closed.
+  int run(const std::function<void()> &Done = nullptr) {
+    start();
     for (;;) {
-      auto ReceivedInfo = receiveData(mConnectionFD, Buffer.get(), mBufferSize);
+      // Do not hold a receive buffer while the connection is idle. Errors
+      // are reported by the following receiveData().
+      if (mInput.empty())
+        waitData(mConnectionFD);
+      auto ReceivedInfo =
+        receiveData(mConnectionFD, prepare(), mOptions.BufferSize);
       if (!ReceivedInfo.second) {
         mOn(bcl::net::SocketStatus::ReceiveError, mConnection);
-        closeSocket(false);
+        close(false, Done);
         return 1;
       }
       if (ReceivedInfo.first == 0) {
-        closeSocket(true);
+        close(true, Done);
         return 0;
       }
-      Buffer.get()[ReceivedInfo.first] = '\0';
-      mOn(bcl::net::SocketStatus::Receive, mConnection);
-      for (auto &Callback : mReceiveCallbacks)
-        Callback(std::string(Buffer.get()));
-      if (mState == State::OnClose) {
-        closeSocket(false);
+      if (!process(ReceivedInfo.first)) {
+        close(false, Done);
         return 1;
       }
     }
   }
+
+  /// \brief Enables the asynchronous mode if it is requested in options.
+  ///
+  /// The socket must be non-blocking. A specified function is called when
+  /// the output buffer cannot be written without blocking.
+  void setWriteRequest(std::function<void()> F) {
+    mWriteRequest = std::move(F);
+  }
+
+  /// \brief Writes data from the output buffer when the socket becomes
+  /// writable.
+  ///
+  /// \return False if the socket should be closed. IsEmpty is set to true if
+  /// all data are written.
+  bool writeOutput(bool &IsEmpty) {
+    SendResult Result;
+    {
+      std::lock_guard<std::mutex> Lock(mOutputMutex);
+      mIsWriteRequested = false;
+      write(Result);
+      IsEmpty = mOutput.empty();
+    }
+    report(Result);
+    return Result.IsOk;
+  }
+
+  /// Reports an error which occurs during receiving of data.
+  void receiveError() const {
+    mOn(bcl::net::SocketStatus::ReceiveError, mConnection);
+  }
+
+  SocketT getFD() const noexcept { return mConnectionFD; }
+
   std::string Data;
- private:
+
+private:
+  /// \brief Passes a received message to listeners.
+  ///
+  /// If a worker pool is used, the task which invokes listeners shares
+  /// ownership of the receive buffer, so the message is not copied.
+  void deliver(const char *Message, std::size_t Size) {
+    if (!mPool)
+      return notify(bcl::net::MessageView(Message, Size, mInput.owner()));
+    auto Owner = mInput.owner();
+    execute([this, Message, Size, Owner]() {
+      notify(bcl::net::MessageView(Message, Size, Owner));
+      if (mState == State::OnClose)
+        shutdownSocket(mConnectionFD);
+    });
+  }
+
+  /// Invokes listeners of a received message.
+  void notify(const bcl::net::MessageView &View) {
+    beginBatch();
+    for (auto &Callback : mReceiveViewCallbacks)
+      Callback(View);
+    if (!mReceiveCallbacks.empty()) {
+      auto Message = View.str();
+      for (auto &Callback : mReceiveCallbacks)
+        Callback(Message);
+    }
+    endBatch();
+  }
+
+  /// Result of an attempt to send messages.
+  struct SendResult {
+    std::size_t SentNumber = 0;
+    bool IsOk = true;
+    bool IsDropped = false;
+    bool IsHighWatermark = false;
+    bool IsLowWatermark = false;
+  };
+
+  bool isAsync() const noexcept {
+    return mOptions.IsAsyncSend && mWriteRequest;
+  }
+
+  /// Starts to queue sent messages if batching is enabled.
+  void beginBatch() {
+    if (mOptions.BatchSize == 0)
+      return;
+    std::lock_guard<std::mutex> Lock(mOutputMutex);
+    ++mBatchDepth;
+  }
+
+  /// Sends queued messages if there is no more active batches.
+  void endBatch() {
+    if (mOptions.BatchSize == 0)
+      return;
+    SendResult Result;
+    {
+      std::lock_guard<std::mutex> Lock(mOutputMutex);
+      assert(mBatchDepth > 0 && "Batch is not started!");
+      if (--mBatchDepth > 0 || mOutput.empty())
+        return;
+      if (isAsync())
+        write(Result);
+      else
+        flush({}, Result);
+    }
+    report(Result);
+  }
+
+  /// Returns the total size of specified chunks of data.
+  static std::size_t sizeOf(const std::vector<DataRef> &Chunks) noexcept {
+    std::size_t Size = 0;
+    for (auto &C : Chunks)
+      Size += C.Size;
+    return Size;
+  }
+
+  /// Stores a message at the end of the output buffer.
+  void push(const std::vector<DataRef> &Chunks) const {
+    std::string Queued;
+    Queued.reserve(sizeOf(Chunks));
+    for (auto &C : Chunks)
+      Queued.append(C.Data, C.Size);
+    mOutputSize += Queued.size();
+    mOutput.push_back(std::move(Queued));
+  }
+
+  /// Appends data from the output buffer to a specified list of chunks.
+  void collect(std::vector<DataRef> &Chunks) const {
+    auto Offset = mOutputOffset;
+    for (auto &Queued : mOutput) {
+      Chunks.push_back(DataRef{Queued.data() + Offset, Queued.size() - Offset});
+      Offset = 0;
+    }
+  }
+
+  /// Removes written data from the output buffer.
+  void consume(std::size_t Size, SendResult &Result) const {
+    mOutputSize -= Size;
+    while (Size > 0) {
+      auto Rest = mOutput.front().size() - mOutputOffset;
+      if (Size < Rest) {
+        mOutputOffset += Size;
+        break;
+      }
+      Size -= Rest;
+      mOutput.pop_front();
+      mOutputOffset = 0;
+      ++Result.SentNumber;
+    }
+    if (mIsHighWatermark && mOutputSize <= mOptions.OutputLowWatermark) {
+      mIsHighWatermark = false;
+      Result.IsLowWatermark = true;
+    }
+  }
+
+  /// \brief Sends all data from the output buffer followed by specified
+  /// chunks of data which represent a single message (if it is not empty).
+  ///
+  /// This waits until all data are written. The output mutex must be locked.
+  void flush(std::vector<DataRef> Chunks, SendResult &Result) const {
+    auto MessageNumber = mOutput.size() + (Chunks.empty() ? 0 : 1);
+    std::vector<DataRef> Queued;
+    collect(Queued);
+    Chunks.insert(Chunks.begin(), Queued.begin(), Queued.end());
+    Result.IsOk = sendData(mConnectionFD, Chunks.data(), Chunks.size());
+    mOutput.clear();
+    mOutputOffset = mOutputSize = 0;
+    if (Result.IsOk)
+      Result.SentNumber += MessageNumber;
+    if (mIsHighWatermark) {
+      mIsHighWatermark = false;
+      Result.IsLowWatermark = true;
+    }
+  }
+
+  /// \brief Stores a message in the output buffer and tries to write it.
+  ///
+  /// An overflow policy is applied if the buffer is full. The output mutex
+  /// must be locked with a specified lock.
+  void enqueue(std::unique_lock<std::mutex> &Lock,
+      std::vector<DataRef> &Chunks, SendResult &Result) const {
+    auto Size = sizeOf(Chunks);
+    if (mOptions.OutputMaxSize > 0 &&
+        mOutputSize + Size > mOptions.OutputMaxSize) {
+      switch (mOptions.Overflow) {
+      case bcl::net::OverflowPolicy::Drop:
+        Result.IsDropped = true;
+        return;
+      case bcl::net::OverflowPolicy::Close:
+        Result.IsOk = false;
+        // Notify an event loop which maintains this connection, the state
+        // is checked under the close mutex, so a descriptor which has been
+        // already closed (and possibly reused) is not shut down.
+        shutdown();
+        return;
+      default:
+        if (!waitOutput(Lock, Size, Result))
+          return;
+      }
+    }
+    push(Chunks);
+    if (!mIsHighWatermark && mOutputSize > mOptions.OutputHighWatermark) {
+      mIsHighWatermark = true;
+      Result.IsHighWatermark = true;
+    }
+    if (mBatchDepth == 0 || mOutputSize > mOptions.BatchSize)
+      write(Result);
+  }
+
+  /// \brief Waits until a message of a specified size fits into the output
+  /// buffer.
+  ///
+  /// The output mutex is released while the socket is not writable, so
+  /// the event loop which maintains this connection and other senders are
+  /// not blocked. The buffer may be still full on return if a message does
+  /// not fit into an empty buffer.
+  /// \return False if the message must not be sent.
+  bool waitOutput(std::unique_lock<std::mutex> &Lock, std::size_t Size,
+      SendResult &Result) const {
+    for (;;) {
+      write(Result);
+      if (!Result.IsOk)
+        return false;
+      if (mOutputSize + Size <= mOptions.OutputMaxSize || mOutput.empty())
+        return true;
+      Lock.unlock();
+      // The connection may be closed by another thread, so the descriptor
+      // is polled with a timeout and the state is checked again.
+      waitWritable(mConnectionFD, 100);
+      Lock.lock();
+      if (mState != State::Open)
+        return false;
+    }
+  }
+
+  /// \brief Writes data from the output buffer without blocking.
+  ///
+  /// If some data are not written, an event loop is asked to write them
+  /// when the socket becomes writable. The output mutex must be locked.
+  void write(SendResult &Result) const {
+    if (mOutput.empty())
+      return;
+    std::vector<DataRef> Chunks;
+    collect(Chunks);
+    std::size_t Size = 0;
+    if (!sendData(mConnectionFD, Chunks.data(), Chunks.size(), &Size)) {
+      Result.IsOk = false;
+      mOutput.clear();
+      mOutputOffset = mOutputSize = 0;
+      return;
+    }
+    consume(Size, Result);
+    if (!mOutput.empty() && !mIsWriteRequested) {
+      mIsWriteRequested = true;
+      mWriteRequest();
+    }
+  }
+
+  /// Notifies a status handler about result of an attempt to send messages.
+  void report(const SendResult &Result) const {
+    for (std::size_t I = 0; I < Result.SentNumber; ++I)
+      mOn(bcl::net::SocketStatus::Send, mConnection);
+    if (!Result.IsOk) {
+      mOn(bcl::net::SocketStatus::SendError, mConnection);
+      mState = State::OnClose;
+      return;
+    }
+    if (Result.IsDropped)
+      mOn(bcl::net::SocketStatus::SendDrop, mConnection);
+    if (Result.IsHighWatermark)
+      mOn(bcl::net::SocketStatus::SendHighWatermark, mConnection);
+    if (Result.IsLowWatermark)
+      mOn(bcl::net::SocketStatus::SendLowWatermark, mConnection);
+  }
+
+  /// Executes a specified task in a worker pool if it is available.
+  void execute(std::function<void()> F) {
+    if (!mPool)
+      return F();
+    auto Self = shared_from_this();
+    mPool->submit(mStrand, [Self, F]() { F(); });
+  }
+
   void closeSocket(bool IsOk) const {
+    std::unique_lock<std::mutex> Lock(mCloseMutex);
+    if (mState == State::OnClose)
+      IsOk = false;
     mState = State::Closed;
-    if (!::closeSocket(mConnectionFD)) {
+    auto IsClosed = ::closeSocket(mConnectionFD);
+    Lock.unlock();
+    if (!IsClosed) {
       IsOk = false;
       mOn(bcl::net::SocketStatus::CloseError, mConnection);
     } else {
@@ -257,18 +1295,295 @@ public:
 
   SocketT mConnectionFD;
   bcl::net::Connection mConnection;
-  std::size_t mBufferSize;
+  bcl::net::ServerOptions mOptions;
   bcl::net::SocketStatusHandler mOn;
+  WorkerPool *mPool;
+  std::function<void(const bcl::net::ViewSocket *)> mCreate;
+  MessageBuffer mInput;
+  WorkerPool::Strand mStrand;
   mutable std::vector<ReceiveCallback> mReceiveCallbacks;
+  mutable std::vector<ReceiveViewCallback> mReceiveViewCallbacks;
+  std::function<void()> mWriteRequest;
+  mutable std::mutex mOutputMutex;
+  mutable std::deque<std::string> mOutput;
+  mutable std::size_t mOutputOffset = 0;
+  mutable std::size_t mOutputSize = 0;
+  mutable bool mIsHighWatermark = false;
+  mutable bool mIsWriteRequested = false;
+  std::size_t mBatchDepth = 0;
   mutable std::vector<ClosedCallback> mClosedCallbacks;
-  mutable State mState = State::Open;
+  mutable std::mutex mCloseMutex;
+  mutable std::atomic<State> mState{State::Open};
 };
+
+/// Number of active connections which is limited by a maximum number of
+/// connections.
+class ConnectionSlots : private bcl::Uncopyable {
+public:
+  explicit ConnectionSlots(std::size_t MaxNumber) : mMaxNumber(MaxNumber) {}
+
+  /// Waits for a free slot and occupies it.
+  void acquire() {
+    std::unique_lock<std::mutex> Lock(mMutex);
+    mFree.wait(Lock, [this]() { return mActiveNumber < mMaxNumber; });
+    ++mActiveNumber;
+  }
+
+  /// Frees a slot which has been previously occupied.
+  void release() {
+    {
+      std::lock_guard<std::mutex> Lock(mMutex);
+      assert(mActiveNumber > 0 && "There is no occupied slots!");
+      --mActiveNumber;
+    }
+    mFree.notify_one();
+  }
+
+private:
+  std::size_t mMaxNumber;
+  std::size_t mActiveNumber = 0;
+  std::mutex mMutex;
+  std::condition_variable mFree;
+};
+
+#ifndef _WIN32
+/// \brief This multiplexes connections in a single thread.
+///
+/// Connections are added from another thread, a pipe is used to wake up
+/// the loop when a new connection is added. Idle connections do not hold
+/// receive buffers, a buffer is taken from a pool when data are available.
+class EventLoop : private bcl::Uncopyable {
+public:
+  EventLoop(std::size_t BufferSize, ConnectionSlots &Slots)
+    : mBufferSize(BufferSize)
+    , mSlots(Slots) {}
+
+  ~EventLoop() {
+    for (auto FD : mWakeUp)
+      if (FD >= 0)
+        ::closeSocket(FD);
+#ifdef __linux__
+    if (mPollFD >= 0)
+      ::closeSocket(mPollFD);
+#endif
+  }
+
+  /// Creates descriptors which are necessary to wait for events.
+  bool initialize() {
+    if (pipe(mWakeUp) != 0 || !setNonBlocking(mWakeUp[0]))
+      return false;
+#ifdef __linux__
+    mPollFD = epoll_create1(0);
+    return mPollFD >= 0 && watch(mWakeUp[0]);
+#else
+    return true;
+#endif
+  }
+
+  /// Adds a new connection to the loop, the socket must be non-blocking.
+  void add(std::shared_ptr<SocketImp> S) {
+    auto FD = S->getFD();
+    S->setWriteRequest([this, FD]() { requestWrite(FD); });
+    {
+      std::lock_guard<std::mutex> Lock(mMutex);
+      mPending.push_back(std::move(S));
+    }
+    wakeUp();
+  }
+
+  /// Asks the loop to write buffered data when a socket becomes writable.
+  void requestWrite(SocketT FD) {
+    {
+      std::lock_guard<std::mutex> Lock(mMutex);
+      mWriteRequests.push_back(FD);
+    }
+    wakeUp();
+  }
+
+  /// Waits for events and processes them.
+  void run() {
+#ifdef __linux__
+    std::vector<epoll_event> Events(64);
+    for (;;) {
+      auto Number = epoll_wait(mPollFD, Events.data(), Events.size(), -1);
+      if (Number < 0 && errno != EINTR)
+        return;
+      for (int I = 0; I < Number; ++I) {
+        auto FD = Events[I].data.fd;
+        if (FD == mWakeUp[0]) {
+          addPending();
+          continue;
+        }
+        if (Events[I].events & EPOLLOUT)
+          writeOutput(FD);
+        if (Events[I].events & ~EPOLLOUT)
+          receive(FD);
+      }
+    }
+#else
+    std::vector<pollfd> Events;
+    for (;;) {
+      Events.clear();
+      Events.push_back(pollfd{mWakeUp[0], POLLIN, 0});
+      for (auto &S : mSockets)
+        Events.push_back(pollfd{S.first,
+          static_cast<short>(mWriters.count(S.first) ? POLLIN | POLLOUT :
+                                                       POLLIN), 0});
+      if (poll(Events.data(), Events.size(), -1) < 0 && errno != EINTR)
+        return;
+      for (auto &Event : Events) {
+        if (Event.revents == 0)
+          continue;
+        if (Event.fd == mWakeUp[0]) {
+          addPending();
+          continue;
+        }
+        if (Event.revents & POLLOUT)
+          writeOutput(Event.fd);
+        if (Event.revents & ~POLLOUT)
+          receive(Event.fd);
+      }
+    }
+#endif
+  }
+
+private:
+#ifdef __linux__
+  bool watch(SocketT FD) {
+    epoll_event Event;
+    Event.events = EPOLLIN;
+    Event.data.fd = FD;
+    return epoll_ctl(mPollFD, EPOLL_CTL_ADD, FD, &Event) == 0;
+  }
+#endif
+
+  /// Starts or stops waiting until a socket becomes writable.
+  void watchWrite(SocketT FD, bool IsEnabled) {
+#ifdef __linux__
+    epoll_event Event;
+    Event.events = IsEnabled ? EPOLLIN | EPOLLOUT : EPOLLIN;
+    Event.data.fd = FD;
+    epoll_ctl(mPollFD, EPOLL_CTL_MOD, FD, &Event);
+#else
+    if (IsEnabled)
+      mWriters.insert(FD);
+    else
+      mWriters.erase(FD);
+#endif
+  }
+
+  void wakeUp() {
+    char Byte = 0;
+    while (write(mWakeUp[1], &Byte, 1) < 0 && errno == EINTR);
+  }
+
+  /// Starts processing of connections which have been added to the loop and
+  /// processes requests to write buffered data.
+  void addPending() {
+    char Bytes[64];
+    while (read(mWakeUp[0], Bytes, sizeof(Bytes)) > 0);
+    std::vector<std::shared_ptr<SocketImp>> Pending;
+    std::vector<SocketT> WriteRequests;
+    {
+      std::lock_guard<std::mutex> Lock(mMutex);
+      Pending.swap(mPending);
+      WriteRequests.swap(mWriteRequests);
+    }
+    for (auto &S : Pending) {
+      auto FD = S->getFD();
+      auto I = mSockets.emplace(FD, std::move(S)).first;
+      I->second->start();
+#ifdef __linux__
+      if (!watch(FD)) {
+        I->second->receiveError();
+        remove(I, false);
+      }
+#endif
+    }
+    for (auto FD : WriteRequests)
+      if (mSockets.count(FD))
+        watchWrite(FD, true);
+  }
+
+  /// Writes buffered data to a specified connection.
+  void writeOutput(SocketT FD) {
+    auto I = mSockets.find(FD);
+    if (I == mSockets.end())
+      return;
+    bool IsEmpty = false;
+    if (!I->second->writeOutput(IsEmpty))
+      remove(I, false);
+    else if (IsEmpty)
+      watchWrite(FD, false);
+  }
+
+  /// Receives a chunk of data from a specified connection.
+  void receive(SocketT FD) {
+    auto I = mSockets.find(FD);
+    if (I == mSockets.end())
+      return;
+    auto Size = recv(FD, I->second->prepare(), mBufferSize, 0);
+    if (Size > 0) {
+      if (!I->second->process(Size))
+        remove(I, false);
+    } else if (Size == 0) {
+      remove(I, true);
+    } else if (errno != EINTR && errno != EAGAIN && errno != EWOULDBLOCK) {
+      I->second->receiveError();
+      remove(I, false);
+    } else {
+      I->second->unprepare();
+    }
+  }
+
+  /// Closes a connection and frees its slot.
+  void remove(std::unordered_map<SocketT,
+      std::shared_ptr<SocketImp>>::iterator I, bool IsOk) {
+#ifdef __linux__
+    epoll_ctl(mPollFD, EPOLL_CTL_DEL, I->first, nullptr);
+#else
+    mWriters.erase(I->first);
+#endif
+    auto S = std::move(I->second);
+    mSockets.erase(I);
+    S->close(IsOk, [this]() { mSlots.release(); });
+  }
+
+  std::size_t mBufferSize;
+  ConnectionSlots &mSlots;
+  int mWakeUp[2] = {-1, -1};
+#ifdef __linux__
+  int mPollFD = -1;
+#endif
+#ifndef __linux__
+  std::unordered_set<SocketT> mWriters;
+#endif
+  std::mutex mMutex;
+  std::vector<std::shared_ptr<SocketImp>> mPending;
+  std::vector<SocketT> mWriteRequests;
+  std::unordered_map<SocketT, std::shared_ptr<SocketImp>> mSockets;
+};
+#endif
 }
 
 void bcl::net::startServer(const net::AddressT &Address, net::PortT PortNo,
     std::size_t ConnectionMaxNumber, const net::SocketStatusHandler &on,
     std::size_t BufferSize) {
+  net::ServerOptions Options;
+  Options.ConnectionMaxNumber = ConnectionMaxNumber;
+  Options.BufferSize = BufferSize;
+  startServer(Address, PortNo, Options, on);
+}
+
+void bcl::net::startServer(const net::AddressT &Address, net::PortT PortNo,
+    const net::ServerOptions &Options, const net::SocketStatusHandler &on) {
+  auto BufferSize = Options.BufferSize;
   net::Connection PreConnection(Address, PortNo);
+  if (Options.Framing == net::FramingMode::Delimiter &&
+      Options.Delimiter.empty()) {
+    on(net::SocketStatus::OptionError, PreConnection);
+    return;
+  }
   if (!initialize()) {
     on(net::SocketStatus::InitializeError, PreConnection);
     return;
@@ -280,10 +1595,11 @@ void bcl::net::startServer(const net::AddressT &Address, net::PortT PortNo,
       on(net::SocketStatus::Close, C);
   };
   SocketT SocketFD;
+  std::size_t AcceptorNumber = 1;
   {
     // Start scope here to early destroy AddressInfo.
     AddressInfoT AddressInfo;
-    if (!getAddressInfo(AF_INET, SOCK_STREAM, 0, Address, PortNo,
+    if (!getAddressInfo(AF_UNSPEC, SOCK_STREAM, 0, Address, PortNo,
                         AddressInfo)) {
       on(net::SocketStatus::HostnameError, PreConnection);
       finalize();
@@ -297,12 +1613,19 @@ void bcl::net::startServer(const net::AddressT &Address, net::PortT PortNo,
     }
     SocketFD = SocketInfo.first;
     // Use it to enable binding while socket is in TIME_WAIT state.
-    if (!setSocketOptions(SocketFD)) {
+    if (!setSocketOptions(SocketFD) || !setBufferSizes(SocketFD, Options) ||
+        (getDomain(AddressInfo) == AF_INET6 && !setDualStack(SocketFD))) {
       on(net::SocketStatus::OptionError, PreConnection);
       closeAndLog(SocketFD, PreConnection);
       finalize();
       return;
     }
+#ifndef _WIN32
+    if (Options.Mode == net::ServerMode::EventLoop &&
+        Options.AcceptorNumber > 1 && AddressInfo.Domain != AF_UNIX &&
+        setReusePort(SocketFD))
+      AcceptorNumber = Options.AcceptorNumber;
+#endif
     if (!bindSocket(SocketFD, AddressInfo)) {
       on(net::SocketStatus::BindError, PreConnection);
       closeAndLog(SocketFD, PreConnection);
@@ -310,8 +1633,9 @@ void bcl::net::startServer(const net::AddressT &Address, net::PortT PortNo,
       return;
     }
   }
-  sockaddr_in ServerAddr;
+  sockaddr_storage ServerAddr;
   socklen_t ServerAddrLength = sizeof(ServerAddr);
+  std::memset(&ServerAddr, 0, sizeof(ServerAddr));
   if (getsockname(SocketFD,
         (sockaddr *)&ServerAddr, &ServerAddrLength) != 0) {
     on(net::SocketStatus::ServerAddressError, PreConnection);
@@ -319,71 +1643,237 @@ void bcl::net::startServer(const net::AddressT &Address, net::PortT PortNo,
     finalize();
     return;
   }
-  net::Connection Connection(
-    inet_ntoa(ServerAddr.sin_addr), ntohs(ServerAddr.sin_port));
-  if (listen(SocketFD, 5)) {
-    on(net::SocketStatus::ListenError, Connection);
-    closeAndLog(SocketFD, Connection);
-    finalize();
-    return;
+  auto ServerAddrInfo = toAddress(ServerAddr);
+  net::Connection Connection(ServerAddrInfo.first, ServerAddrInfo.second);
+  std::vector<SocketT> Listeners(1, SocketFD);
+  auto closeListeners = [&Listeners, &Connection, closeAndLog]() {
+    for (auto S : Listeners)
+      closeAndLog(S, Connection);
+  };
+#ifndef _WIN32
+  // Bind other sockets to the actual address of the first one, so all of
+  // them share the same port even if it has been chosen by the system.
+  while (Listeners.size() < AcceptorNumber) {
+    auto S = socket(ServerAddr.ss_family, SOCK_STREAM, 0);
+    if (S < 0) {
+      on(net::SocketStatus::CreateError, Connection);
+      closeListeners();
+      finalize();
+      return;
+    }
+    Listeners.push_back(S);
+    if (!setSocketOptions(S) || !setReusePort(S) ||
+        !setBufferSizes(S, Options) ||
+        (ServerAddr.ss_family == AF_INET6 && !setDualStack(S))) {
+      on(net::SocketStatus::OptionError, Connection);
+      closeListeners();
+      finalize();
+      return;
+    }
+    if (bind(S, (sockaddr *)&ServerAddr, ServerAddrLength) != 0) {
+      on(net::SocketStatus::BindError, Connection);
+      closeListeners();
+      finalize();
+      return;
+    }
   }
-  on(net::SocketStatus::Listen, Connection);
-  std::unordered_map<SocketT, std::future<int>> ActiveSockets;
-  if (ConnectionMaxNumber == 0 || ConnectionMaxNumber > ActiveSockets.max_size())
-    ConnectionMaxNumber = ActiveSockets.max_size();
-  auto engine =
-    [BufferSize, &on, closeAndLog](
-        SocketT ConnectionFD, net::Connection &&C) -> int {
-      auto Engine = bcl::make_unique<SocketImp>(ConnectionFD, C, BufferSize, on);
-      return Engine->run();
-    };
-  auto sanitizeConnections = [&ActiveSockets]() {
-    auto Size = ActiveSockets.size();
-    for (auto I = ActiveSockets.begin(), EI = ActiveSockets.end(); I != EI;) {
-      auto Status = I->second.wait_for(std::chrono::seconds(0));
-      if (Status == std::future_status::ready)
-        I = ActiveSockets.erase(I);
-      else
-        ++I;
+#endif
+  auto Backlog = Options.Backlog > 0 ? Options.Backlog : SOMAXCONN;
+  for (auto S : Listeners)
+    if (listen(S, Backlog)) {
+      on(net::SocketStatus::ListenError, Connection);
+      closeListeners();
+      finalize();
+      return;
     }
-    return Size != ActiveSockets.size();
-  };
-  for(;;) {
-    if (ActiveSockets.size() == ConnectionMaxNumber) {
-      while (!sanitizeConnections())
-        std::this_thread::sleep_for(std::chrono::seconds(5));
-    } else if (ActiveSockets.size() > ConnectionMaxNumber / 2) {
-      sanitizeConnections();
-    }
-    sockaddr_in ClientAddr;
+  on(net::SocketStatus::Listen, Connection);
+  auto acceptClient = [&Connection, &Options, &on, closeAndLog](
+      SocketT ListenerFD,
+      const std::function<void(SocketT, net::Connection &)> &F) {
+    sockaddr_storage ClientAddr;
     socklen_t ClientAddrLength = sizeof(ClientAddr);
+    std::memset(&ClientAddr, 0, sizeof(ClientAddr));
     SocketT ConnectionFD =
-      accept(SocketFD, (sockaddr *)&ClientAddr, &ClientAddrLength);
+      accept(ListenerFD, (sockaddr *)&ClientAddr, &ClientAddrLength);
     if (ConnectionFD < 0) {
       on(net::SocketStatus::AcceptError, Connection);
-      continue;
+      return false;
     }
-    sockaddr_in ActualServerAddr;
+    sockaddr_storage ActualServerAddr;
     socklen_t ActualServerAddrLength = sizeof(ActualServerAddr);
+    std::memset(&ActualServerAddr, 0, sizeof(ActualServerAddr));
     if (getsockname(ConnectionFD,
          (sockaddr *)&ActualServerAddr, &ActualServerAddrLength) != 0) {
       on(net::SocketStatus::ServerAddressError, Connection);
       closeAndLog(ConnectionFD, Connection);
-      continue;
+      return false;
     }
-    net::Connection NewConnection(
-      inet_ntoa(ActualServerAddr.sin_addr), ntohs(ActualServerAddr.sin_port),
-      inet_ntoa(ClientAddr.sin_addr), ntohs(ClientAddr.sin_port));
+    auto ServerInfo = toAddress(ActualServerAddr);
+    auto ClientInfo = toAddress(ClientAddr);
+    net::Connection NewConnection(ServerInfo.first, ServerInfo.second,
+      ClientInfo.first, ClientInfo.second);
     on(net::SocketStatus::Accept, NewConnection);
-    auto EngineItr = ActiveSockets.emplace(std::piecewise_construct,
-      std::forward_as_tuple(ConnectionFD),
-      std::forward_as_tuple()).first;
-    assert(!EngineItr->second.valid() ||
-           EngineItr->second.wait_for(std::chrono::seconds(0))
-             == std::future_status::ready && "Unable to join thread!");
-    EngineItr->second = std::async(std::launch::async,
-      engine, ConnectionFD, std::move(NewConnection));
-  }
-  closeAndLog(SocketFD, Connection);
+    disableSigPipe(ConnectionFD);
+    if ((ClientAddr.ss_family == AF_INET ||
+         ClientAddr.ss_family == AF_INET6) &&
+        !setTcpOptions(ConnectionFD, Options)) {
+      on(net::SocketStatus::OptionError, NewConnection);
+      closeAndLog(ConnectionFD, NewConnection);
+      return false;
+    }
+    F(ConnectionFD, NewConnection);
+    return true;
+  };
+  std::unique_ptr<WorkerPool> Pool;
+  if (Options.WorkerNumber > 0)
+    Pool = bcl::make_unique<WorkerPool>(Options.WorkerNumber);
+  auto ConnectionMaxNumber = Options.ConnectionMaxNumber;
+  if (ConnectionMaxNumber == 0)
+    ConnectionMaxNumber = std::numeric_limits<std::size_t>::max();
+  ConnectionSlots Slots(ConnectionMaxNumber);
+  // Each accepting thread needs at least one event loop.
+  auto LoopNumber =
+    std::max<std::size_t>(Options.EventLoopNumber, AcceptorNumber);
+  // Retain free buffers which are necessary to receive data in all threads
+  // at the same time, if listeners do not take ownership of messages.
+  auto Buffers = std::make_shared<BufferPool>(
+    Options.Mode == net::ServerMode::EventLoop ?
+      LoopNumber : ConnectionMaxNumber,
+    2 * BufferSize);
+#ifndef _WIN32
+  if (Options.Mode == net::ServerMode::EventLoop) {
+    std::vector<std::unique_ptr<EventLoop>> Loops;
+    std::vector<std::thread> Threads;
+    // Initialize all loops before any of them is started, so the loops can
+    // be safely destroyed on failure.
+    for (std::size_t I = 0; I < LoopNumber; ++I) {
+      Loops.push_back(bcl::make_unique<EventLoop>(BufferSize, Slots));
+      if (!Loops.back()->initialize()) {
+        on(net::SocketStatus::InitializeError, Connection);
+        closeListeners();
+        finalize();
+        return;
+      }
+    }
+    for (std::size_t I = 0; I < LoopNumber; ++I) {
+      Threads.emplace_back(&EventLoop::run, Loops[I].get());
+      if (Options.IsPinned)
+        pinThread(Threads.back(), I);
+    }
+    // The I-th accepting thread distributes connections among loops
+    // I, I + AcceptorNumber, I + 2 * AcceptorNumber, ...
+    auto acceptLoop = [&](std::size_t Acceptor) {
+      auto NextLoop = Acceptor;
+      for (;;) {
+        Slots.acquire();
+        auto IsAccepted = acceptClient(Listeners[Acceptor],
+          [&on, &Slots, &Loops, &NextLoop, &Pool, &Buffers, &Options,
+           AcceptorNumber, Acceptor, closeAndLog](
+              SocketT ConnectionFD, net::Connection &C) {
+            if (!setNonBlocking(ConnectionFD)) {
+              on(net::SocketStatus::OptionError, C);
+              closeAndLog(ConnectionFD, C);
+              Slots.release();
+              return;
+            }
+            Loops[NextLoop]->add(std::make_shared<SocketImp>(
+              ConnectionFD, C, Options, on, Buffers, Pool.get()));
+            NextLoop += AcceptorNumber;
+            if (NextLoop >= Loops.size())
+              NextLoop = Acceptor;
+          });
+        if (!IsAccepted)
+          Slots.release();
+      }
+    };
+    if (AcceptorNumber == 1) {
+      acceptLoop(0);
+    } else {
+      for (std::size_t I = 0; I < AcceptorNumber; ++I) {
+        Threads.emplace_back(acceptLoop, I);
+        if (Options.IsPinned)
+          pinThread(Threads.back(), I);
+      }
+    }
+    for (auto &T : Threads)
+      T.join();
+    closeListeners();
+    finalize();
+    return;
+  }
+#endif
+  auto engine = [&Options, &on, &Pool, &Buffers, &Slots](
+      SocketT ConnectionFD, const net::Connection &C) {
+    auto Engine = std::make_shared<SocketImp>(
+      ConnectionFD, C, Options, on, Buffers, Pool.get());
+    Engine->run([&Slots]() { Slots.release(); });
+  };
+  for (;;) {
+    // A slot is released when a connection is closed, so the next client is
+    // accepted as soon as possible.
+    Slots.acquire();
+    auto IsAccepted = acceptClient(SocketFD,
+        [&engine, &Slots, &on, closeAndLog](
+          SocketT ConnectionFD, net::Connection &NewConnection) {
+      try {
+        std::thread(engine, ConnectionFD, NewConnection).detach();
+      } catch (const std::system_error &) {
+        on(net::SocketStatus::CreateError, NewConnection);
+        closeAndLog(ConnectionFD, NewConnection);
+        Slots.release();
+      }
+    });
+    if (!IsAccepted)
+      Slots.release();
+  }
+  closeListeners();
   finalize();
 }
+
+std::shared_ptr<const net::ViewSocket> bcl::net::connectLocal(
+    const std::function<void(const net::ViewSocket *)> &createClient,
+    const net::ServerOptions &Options, const net::SocketStatusHandler &on) {
+  net::Connection Connection(UnixPrefix, 0, UnixPrefix, 0);
+#ifdef _WIN32
+  on(net::SocketStatus::CreateError, Connection);
+  return nullptr;
+#else
+  if (Options.Framing == net::FramingMode::Delimiter &&
+      Options.Delimiter.empty()) {
+    on(net::SocketStatus::OptionError, Connection);
+    return nullptr;
+  }
+  SocketT FD[2];
+  if (socketpair(AF_UNIX, SOCK_STREAM, 0, FD) != 0) {
+    on(net::SocketStatus::CreateError, Connection);
+    return nullptr;
+  }
+  disableSigPipe(FD[0]);
+  disableSigPipe(FD[1]);
+  auto Buffers = std::make_shared<BufferPool>(2, 2 * Options.BufferSize);
+  auto Server = std::make_shared<SocketImp>(
+    FD[0], Connection, Options, on, Buffers);
+  auto Client = std::make_shared<SocketImp>(
+    FD[1], Connection, Options, on, Buffers);
+  Client->setCreate(createClient);
+  try {
+    std::thread([Server]() { Server->run(); }).detach();
+  } catch (const std::system_error &) {
+    on(net::SocketStatus::CreateError, Connection);
+    ::closeSocket(FD[0]);
+    ::closeSocket(FD[1]);
+    return nullptr;
+  }
+  try {
+    std::thread([Client]() { Client->run(); }).detach();
+  } catch (const std::system_error &) {
+    on(net::SocketStatus::CreateError, Connection);
+    Server->shutdown();
+    ::closeSocket(FD[1]);
+    return nullptr;
+  }
+  // The connection is closed when the last user of the client is destroyed.
+  return std::shared_ptr<const net::ViewSocket>(Client.get(),
+    [Client](const net::ViewSocket *) { Client->shutdown(); });
+#endif
+}
@@ -0,0 +1,106 @@
+//===- json_construct.cpp ---- JSON Construction Test --------------*- C -*-===//
+//
+//                       Base Construction Library (BCL)
+//
+// Copyright 2018 Nikita Kataev
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements test which checks that values are constructed in
+// place when containers are parsed.
+//
+//===----------------------------------------------------------------------===//
+
+#include <bcl/bcl-config.h>
+#include <bcl/Json.h>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+/// Value which counts number of its constructions.
+struct Heavy {
+  static int Constructed;
+  static int Copied;
+  Heavy() { ++Constructed; }
+  Heavy(const Heavy &H) : Value(H.Value) { ++Copied; }
+  Heavy(Heavy &&H) : Value(std::move(H.Value)) { ++Copied; }
+  Heavy & operator=(const Heavy &) = default;
+  Heavy & operator=(Heavy &&) = default;
+  std::string Value;
+};
+
+int Heavy::Constructed = 0;
+int Heavy::Copied = 0;
+
+namespace json {
+template<> struct Traits<Heavy> {
+  static bool parse(Heavy &Dest, Lexer &Lex) {
+    return Traits<std::string>::parse(Dest.Value, Lex);
+  }
+  static void unparse(String &JSON, const Heavy &Obj) {
+    Traits<std::string>::unparse(JSON, Obj.Value);
+  }
+};
+}
+
+bool checkConstructions(const char *What, int Constructed) {
+  std::cout << "Construct " << What << ": ";
+  if (Heavy::Constructed != Constructed || Heavy::Copied != 0) {
+    std::cout << "fail (" << Heavy::Constructed << " constructed, " <<
+      Heavy::Copied << " copied)" << std::endl;
+    return false;
+  }
+  std::cout << "ok" << std::endl;
+  Heavy::Constructed = 0;
+  return true;
+}
+
+bool checkString(const json::String &JSON, const std::string &Expected) {
+  std::cout << "Parse " << JSON << ": ";
+  json::Parser<> P(JSON);
+  std::string S("previous value");
+  if (!P.parse(S) || S != Expected) {
+    std::cout << "fail" << std::endl;
+    return false;
+  }
+  std::cout << "ok" << std::endl;
+  return true;
+}
+
+int main() {
+  std::cout << "BCL version " << BCL_VERSION_STRING << std::endl;
+  bool Ok = true;
+  std::vector<Heavy> V;
+  json::Parser<> VP(R"j(["a","b","c"])j");
+  Ok &= VP.parse(V) && V.size() == 3 && V[2].Value == "c";
+  Ok &= checkConstructions("vector", 3);
+  std::map<int, Heavy> M;
+  json::Parser<> MP(R"j({"1":"a","2":"b"})j");
+  Ok &= MP.parse(M) && M.size() == 2 && M[2].Value == "b";
+  Ok &= checkConstructions("map", 2);
+  std::vector<int> Ints{ 7, 7, 7, 7 };
+  json::Parser<> IP("[1,2]");
+  if (!IP.parse(Ints) || Ints != std::vector<int>{ 1, 2 }) {
+    std::cout << "Unable to parse array of integers" << std::endl;
+    Ok = false;
+  }
+  Ok &= checkString(R"j("abc")j", "abc");
+  Ok &= checkString(R"j("")j", "");
+  Ok &= checkString(R"j("a\n")j", "a\n");
+  Ok &= checkString(R"j("\tb\\")j", "\tb\\");
+  Ok &= checkString(R"j("a\qb")j", "aqb");
+  return Ok ? 0 : 1;
+}
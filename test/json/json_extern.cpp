@@ -0,0 +1,78 @@
+//===- json_extern.cpp ---- JSON Precompiled Templates Test --------*- C -*-===//
+//
+//                       Base Construction Library (BCL)
+//
+// Copyright 2018 Nikita Kataev
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements test which uses templates explicitly instantiated in
+// the BCLJson library.
+//
+//===----------------------------------------------------------------------===//
+
+#include <bcl/bcl-config.h>
+#include <bcl/Json.h>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#ifndef BCL_JSON_EXTERN_TEMPLATES
+# error "BCL_JSON_EXTERN_TEMPLATES must be defined for users of BCLJson!"
+#endif
+
+template<class Ty> bool check(const json::String &JSON, const Ty &Expected) {
+  std::cout << "Parse " << JSON << ": ";
+  json::Parser<> P(JSON);
+  Ty Obj;
+  json::Parser<> V(JSON);
+  if (!P.parse(Obj) || Obj != Expected || !V.validate<Ty>()) {
+    std::cout << "fail" << std::endl;
+    return false;
+  }
+  std::cout << "ok" << std::endl;
+  return true;
+}
+
+int main() {
+  std::cout << "BCL version " << BCL_VERSION_STRING << std::endl;
+  bool Ok = true;
+  Ok &= check("1", 1);
+  Ok &= check("2.5", 2.5);
+  Ok &= check(R"j("text")j", std::string("text"));
+  Ok &= check("[1,2,3]", std::vector<unsigned>{ 1, 2, 3 });
+  Ok &= check(R"j({"1":"b","0":"a"})j", std::vector<std::string>{ "a", "b" });
+  bcl::Diagnostic Diag("error");
+  Diag.insert(1, "%s", 5, "message");
+  json::Parser<> P(json::Parser<>::unparse(Diag));
+  bcl::Diagnostic Parsed("error");
+  if (!P.parse(Parsed) || Parsed.size() != 1) {
+    std::cout << "Unable to parse diagnostic" << std::endl;
+    Ok = false;
+  }
+  // Statistics are collected by instantiations from the library.
+  json::Parser<> S("[1,2,3]");
+  std::vector<int> V;
+  S.parse(V);
+#ifdef BCL_JSON_STATISTICS
+  if (S.statistics().Tokens != 7) {
+#else
+  if (S.statistics().Tokens != 0) {
+#endif
+    std::cout << "Unexpected statistics" << std::endl;
+    Ok = false;
+  }
+  return Ok ? 0 : 1;
+}
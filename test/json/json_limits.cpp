@@ -0,0 +1,116 @@
+//===- json_limits.cpp ---------- JSON Limits Test ----------------*- C -*-===//
+//
+//                       Base Construction Library (BCL)
+//
+// Copyright 2018 Nikita Kataev
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements test for limits of depth of nested values, number of
+// elements and length of strings in a JSON string.
+//
+//===----------------------------------------------------------------------===//
+
+#include <bcl/bcl-config.h>
+#include <bcl/Json.h>
+#include <iostream>
+#include <map>
+#include <unordered_set>
+#include <vector>
+
+JSON_OBJECT_BEGIN(Human)
+  JSON_PAIR(Name, std::string)
+  JSON_PAIR(Kids, std::vector<std::string>)
+JSON_OBJECT_ROOT_PAIRS(Human, Name, Kids)
+  Human() : JSON_INIT_ROOT {}
+JSON_OBJECT_END(Human)
+JSON_DEFAULT_TRAITS(::, Human)
+
+json::Limits limits(json::Position Depth, json::Position Elements,
+    json::Position Length) {
+  json::Limits L;
+  L.MaxDepth = Depth;
+  L.MaxElements = Elements;
+  L.MaxStringLength = Length;
+  return L;
+}
+
+template<class Ty> bool check(const json::String &JSON,
+    const json::Limits &L, bool Expected, bool UseTape = false) {
+  std::cout << "Parse " << JSON << ": ";
+  json::Parser<> P(JSON);
+  P.setLimits(L);
+  if (UseTape)
+    P.buildTape();
+  Ty Obj;
+  if (P.parse(Obj) != Expected) {
+    std::cout << "fail" << std::endl;
+    for (auto Err : P.errors())
+      std::cout << "  " << Err << std::endl;
+    return false;
+  }
+  std::cout << "ok" << std::endl;
+  if (!Expected)
+    for (auto Err : P.errors())
+      std::cout << "  " << Err << std::endl;
+  return true;
+}
+
+bool checkObject(const json::String &JSON, const json::Limits &L,
+    bool Expected) {
+  std::cout << "Parse object " << JSON << ": ";
+  json::Parser<Human> P(JSON);
+  P.setLimits(L);
+  if (!P.parse() == Expected) {
+    std::cout << "fail" << std::endl;
+    for (auto Err : P.errors())
+      std::cout << "  " << Err << std::endl;
+    return false;
+  }
+  std::cout << "ok" << std::endl;
+  return true;
+}
+
+int main() {
+  std::cout << "BCL version " << BCL_VERSION_STRING << std::endl;
+  using Nested = std::vector<std::vector<std::vector<int>>>;
+  auto Max = json::Limits().MaxDepth;
+  bool Ok = true;
+  Ok &= check<Nested>("[[[1]],[[2,3]]]", limits(3, Max, Max), true);
+  Ok &= check<Nested>("[[[1]],[[2,3]]]", limits(2, Max, Max), false);
+  Ok &= check<Nested>("[[[1]],[[2,3]]]", limits(2, Max, Max), false, true);
+  Ok &= check<std::vector<int>>("[1,2,3]", limits(Max, 3, Max), true);
+  Ok &= check<std::vector<int>>("[1,2,3]", limits(Max, 2, Max), false);
+  Ok &= check<std::vector<int>>("[1,2,3]", limits(Max, 2, Max), false, true);
+  Ok &= check<std::vector<int>>(
+    R"j({"999999999":1})j", limits(Max, 1024, Max), false);
+  Ok &= check<int *>(R"j({"999999999":1})j", limits(Max, 1024, Max), false);
+  Ok &= check<std::unordered_set<int>>("[1,2,3]", limits(Max, 2, Max), false);
+  Ok &= check<std::map<std::string, int>>(
+    R"j({"a":1,"b":2})j", limits(Max, 1, Max), false);
+  Ok &= check<std::string>(R"j("abc")j", limits(Max, Max, 3), true);
+  Ok &= check<std::string>(R"j("abcd")j", limits(Max, Max, 3), false);
+  Ok &= check<std::map<std::string, int>>(
+    R"j({"abcd":1})j", limits(Max, Max, 3), false);
+  Ok &= checkObject(R"j({"name":"Human","Kids":["Ann","Bob"]})j",
+    limits(2, 2, 8), true);
+  Ok &= checkObject(R"j({"name":"Human","Pets":[[[[[1]]]]]})j",
+    limits(2, Max, Max), true);
+  Ok &= checkObject(R"j({"name":"Human","Kids":[["Ann"]]})j",
+    limits(2, Max, Max), false);
+  Ok &= checkObject(R"j({"name":"Human","Kids":["Ann","Bob","Kate"]})j",
+    limits(Max, 2, Max), false);
+  return Ok ? 0 : 1;
+}
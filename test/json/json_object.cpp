@@ -0,0 +1,96 @@
+//===- json_object.cpp ---- JSON Object Declaration Test -----------*- C -*-===//
+//
+//                       Base Construction Library (BCL)
+//
+// Copyright 2018 Nikita Kataev
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements test for declaration of JSON objects with JSON_PAIR,
+// JSON_OBJECT_PAIRS and JSON_OBJECT_ROOT_PAIRS macros. Generated macros
+// are not included, so this also checks that they are not necessary.
+//
+//===----------------------------------------------------------------------===//
+
+#define BCL_JSON_NO_OBJECT_MACROS
+#include <bcl/bcl-config.h>
+#include <bcl/Json.h>
+#include <iostream>
+#include <map>
+#include <type_traits>
+
+#ifdef JSON_OBJECT_PAIR_2
+# error "Generated macros must not be included!"
+#endif
+
+JSON_OBJECT_BEGIN(Point)
+  JSON_PAIR(X, int)
+  JSON_PAIR(Y, int)
+JSON_OBJECT_PAIRS(Point, X, Y)
+JSON_OBJECT_END(Point)
+JSON_DEFAULT_TRAITS(::, Point)
+
+// This object has more pairs than generated macros support.
+JSON_OBJECT_BEGIN(Wide)
+  JSON_PAIR(F1, int) JSON_PAIR(F2, int) JSON_PAIR(F3, int) JSON_PAIR(F4, int)
+  JSON_PAIR(F5, int) JSON_PAIR(F6, int) JSON_PAIR(F7, int) JSON_PAIR(F8, int)
+  JSON_PAIR(F9, int) JSON_PAIR(F10, int) JSON_PAIR(F11, int)
+  JSON_PAIR(F12, int) JSON_PAIR(F13, int) JSON_PAIR(F14, int)
+  JSON_PAIR(F15, int) JSON_PAIR(F16, int) JSON_PAIR(F17, int)
+  JSON_PAIR(F18, int) JSON_PAIR(F19, int) JSON_PAIR(F20, int)
+  JSON_PAIR(F21, int) JSON_PAIR(F22, int) JSON_PAIR(F23, int)
+  JSON_PAIR(F24, int) JSON_PAIR(F25, int) JSON_PAIR(F26, int)
+  JSON_PAIR(F27, int) JSON_PAIR(F28, int) JSON_PAIR(F29, int)
+  JSON_PAIR(F30, int) JSON_PAIR(F31, int) JSON_PAIR(F32, int)
+  JSON_PAIR(Origin, Point)
+  JSON_PAIR(Tags, std::map<std::string, int>)
+JSON_OBJECT_ROOT_PAIRS(Wide, F1, F2, F3, F4, F5, F6, F7, F8, F9, F10, F11,
+  F12, F13, F14, F15, F16, F17, F18, F19, F20, F21, F22, F23, F24, F25, F26,
+  F27, F28, F29, F30, F31, F32, Origin, Tags)
+  Wide() : JSON_INIT_ROOT {}
+JSON_OBJECT_END(Wide)
+JSON_DEFAULT_TRAITS(::, Wide)
+
+static_assert(std::is_same<JSON_VALUE_TYPE(Wide, Tags),
+  std::map<std::string, int>>::value, "Unexpected type of a value!");
+
+int main() {
+  std::cout << "BCL version " << BCL_VERSION_STRING << std::endl;
+  bool Ok = true;
+  Wide W;
+  W[Wide::F1] = 1;
+  W[Wide::F32] = 32;
+  W[Wide::Origin][Point::X] = 3;
+  W[Wide::Origin][Point::Y] = 4;
+  W[Wide::Tags]["a"] = 5;
+  auto JSON = json::Parser<Wide>::unparseAsObject(W);
+  std::cout << JSON << std::endl;
+  json::Parser<Wide> P(JSON);
+  auto O = P.parse();
+  if (!O || !O->is<Wide>()) {
+    std::cout << "Unable to parse object" << std::endl;
+    for (auto Err : P.errors())
+      std::cout << "  " << Err << std::endl;
+    return 1;
+  }
+  auto &PW = O->as<Wide>();
+  if (PW[Wide::F1] != 1 || PW[Wide::F32] != 32 ||
+      PW[Wide::Origin][Point::X] != 3 || PW[Wide::Origin][Point::Y] != 4 ||
+      PW[Wide::Tags].size() != 1 || PW[Wide::Tags]["a"] != 5) {
+    std::cout << "Unexpected values of parsed object" << std::endl;
+    Ok = false;
+  }
+  return Ok ? 0 : 1;
+}
@@ -0,0 +1,73 @@
+//===- json_ordered.cpp ---- JSON Ordered Containers Test ----------*- C -*-===//
+//
+//                       Base Construction Library (BCL)
+//
+// Copyright 2018 Nikita Kataev
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements test for conversion of std::map, std::multimap and
+// std::set from sorted and unsorted JSON strings.
+//
+//===----------------------------------------------------------------------===//
+
+#include <bcl/bcl-config.h>
+#include <bcl/Json.h>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <set>
+#include <string>
+
+template<class Ty>
+bool check(const json::String &JSON, const Ty &Expected, bool IsValid = true) {
+  std::cout << "Parse " << JSON << ": ";
+  json::Parser<> P(JSON);
+  Ty Obj;
+  auto Res = P.parse(Obj);
+  if (Res != IsValid || (Res && Obj != Expected)) {
+    std::cout << "fail" << std::endl;
+    for (auto Err : P.errors())
+      std::cout << "  " << Err << std::endl;
+    return false;
+  }
+  std::cout << "ok" << std::endl;
+  return true;
+}
+
+int main() {
+  std::cout << "BCL version " << BCL_VERSION_STRING << std::endl;
+  bool Ok = true;
+  typedef std::set<int> SetTy;
+  Ok &= check("[1,2,3]", SetTy{ 1, 2, 3 });
+  Ok &= check("[3,1,2]", SetTy{ 1, 2, 3 });
+  Ok &= check("[1,3,2]", SetTy{ 1, 2, 3 });
+  Ok &= check("[1,2,2]", SetTy{}, false);
+  Ok &= check("[3,1,3]", SetTy{}, false);
+  typedef std::set<int, std::greater<int>> GreaterSetTy;
+  Ok &= check("[3,2,1]", GreaterSetTy{ 1, 2, 3 });
+  Ok &= check("[1,2,3]", GreaterSetTy{ 1, 2, 3 });
+  typedef std::map<std::string, int> MapTy;
+  MapTy M{ {"a", 1}, {"b", 2}, {"c", 3} };
+  Ok &= check(json::Parser<>::unparse(M), M);
+  Ok &= check(R"j({"c":3,"a":1,"b":2})j", M);
+  Ok &= check(R"j({"a":1,"c":3,"a":2})j", M, false);
+  Ok &= check(R"j({"a":1,"b":"x"})j", M, false);
+  typedef std::multimap<int, int> MultiMapTy;
+  MultiMapTy MM{ {1, 1}, {1, 2}, {2, 3}, {0, 4} };
+  Ok &= check(json::Parser<>::unparse(MM), MM);
+  Ok &= check(R"j({"1":1,"2":3,"1":2,"0":4})j", MM);
+  return Ok ? 0 : 1;
+}
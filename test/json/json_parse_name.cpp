@@ -0,0 +1,85 @@
+//===- json_parse_name.cpp -- JSON Object Identification Test -----*- C -*-===//
+//
+//                       Base Construction Library (BCL)
+//
+// Copyright 2018 Nikita Kataev
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements test for identification of JSON objects by name in
+// json::Parser<...>::parse().
+//
+//===----------------------------------------------------------------------===//
+
+#include <bcl/bcl-config.h>
+#include <bcl/Json.h>
+#include <iostream>
+
+JSON_OBJECT_BEGIN(Human)
+JSON_OBJECT_ROOT_PAIR_3(Human,
+  Name, std::string, Age, unsigned, Kids, std::vector<std::string>)
+  Human() : JSON_INIT_ROOT {}
+JSON_OBJECT_END(Human)
+JSON_DEFAULT_TRAITS(::, Human)
+
+JSON_OBJECT_BEGIN(Dog)
+JSON_OBJECT_ROOT_PAIR_2(Dog, Name, std::string, Owner, std::string)
+  Dog() : JSON_INIT_ROOT {}
+JSON_OBJECT_END(Dog)
+JSON_DEFAULT_TRAITS(::, Dog)
+
+template<class Ty>
+bool check(const json::String &JSON, const std::string &Name) {
+  std::cout << "Parse " << JSON << ": ";
+  json::Parser<Human, Dog> P(JSON);
+  auto O = P.parse();
+  if (!O || !O->is<Ty>() || O->as<Ty>()[Ty::Name] != Name) {
+    std::cout << "fail" << std::endl;
+    for (auto Err : P.errors())
+      std::cout << "  " << Err << std::endl;
+    return false;
+  }
+  std::cout << "ok" << std::endl;
+  return true;
+}
+
+int main() {
+  std::cout << "BCL version " << BCL_VERSION_STRING << std::endl;
+  bool Ok = true;
+  Ok &= check<Human>(R"j({"name":"Human","Name":"Jon","Age":1})j", "Jon");
+  Ok &= check<Dog>(R"j({"Name":"Rex", "Owner":"Jon", "name":"Dog"})j", "Rex");
+  Ok &= check<Human>(
+    R"j({"Kids":["Ann", "{[}"], "Name":"Jon", "name":"Human"})j", "Jon");
+  json::Parser<Human, Dog> P(R"j({"Name":"Jon","name":"Cat"})j");
+  if (P.parse()) {
+    std::cout << "Object of unknown type has been parsed" << std::endl;
+    Ok = false;
+  }
+  Dog D;
+  D[Dog::Name] = "Rex";
+  D[Dog::Owner] = "Jon";
+  json::Parser<Human, Dog> First(json::Parser<Human, Dog>::unparseAsObject(D));
+  auto O = First.parseNameFirst();
+  if (!O || !O->is<Dog>() || O->as<Dog>()[Dog::Owner] != "Jon") {
+    std::cout << "Unable to parse unparsed object" << std::endl;
+    Ok = false;
+  }
+  json::Parser<Human, Dog> Last(R"j({"Name":"Rex","name":"Dog"})j");
+  if (Last.parseNameFirst()) {
+    std::cout << "Identifier has been searched among all keys" << std::endl;
+    Ok = false;
+  }
+  return Ok ? 0 : 1;
+}
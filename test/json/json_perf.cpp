@@ -0,0 +1,245 @@
+//===- json_perf.cpp ---------- JSON Benchmark --------------------*- C -*-===//
+//
+//                       Base Construction Library (BCL)
+//
+// Copyright 2018 Nikita Kataev
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements performance benchmark for json::Parser. Throughput of
+// parse(), validate() and unparse() is measured on the following corpora:
+// numeric arrays, string-heavy objects, deep nesting and JSON objects with
+// 1, 10 and 30 fields.
+//
+// Besides human-readable report, results are printed as lines in CSV format
+// (corpus,operation,bytes,iterations,seconds,MB/s) which start with 'csv,'.
+//
+//===----------------------------------------------------------------------===//
+
+#include <bcl/bcl-config.h>
+#include <bcl/Json.h>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using TimeT = std::chrono::duration<double>;
+
+JSON_OBJECT_BEGIN(Record1)
+  JSON_PAIR(F1, int)
+JSON_OBJECT_PAIRS(Record1, F1)
+JSON_OBJECT_END(Record1)
+JSON_DEFAULT_TRAITS(::, Record1)
+
+JSON_OBJECT_BEGIN(Record10)
+  JSON_PAIR(F1, int) JSON_PAIR(F2, double) JSON_PAIR(F3, std::string)
+  JSON_PAIR(F4, int) JSON_PAIR(F5, double) JSON_PAIR(F6, std::string)
+  JSON_PAIR(F7, int) JSON_PAIR(F8, double) JSON_PAIR(F9, std::string)
+  JSON_PAIR(F10, unsigned)
+JSON_OBJECT_PAIRS(Record10, F1, F2, F3, F4, F5, F6, F7, F8, F9, F10)
+JSON_OBJECT_END(Record10)
+JSON_DEFAULT_TRAITS(::, Record10)
+
+JSON_OBJECT_BEGIN(Record30)
+  JSON_PAIR(F1, int) JSON_PAIR(F2, double) JSON_PAIR(F3, std::string)
+  JSON_PAIR(F4, int) JSON_PAIR(F5, double) JSON_PAIR(F6, std::string)
+  JSON_PAIR(F7, int) JSON_PAIR(F8, double) JSON_PAIR(F9, std::string)
+  JSON_PAIR(F10, int) JSON_PAIR(F11, double) JSON_PAIR(F12, std::string)
+  JSON_PAIR(F13, int) JSON_PAIR(F14, double) JSON_PAIR(F15, std::string)
+  JSON_PAIR(F16, int) JSON_PAIR(F17, double) JSON_PAIR(F18, std::string)
+  JSON_PAIR(F19, int) JSON_PAIR(F20, double) JSON_PAIR(F21, std::string)
+  JSON_PAIR(F22, int) JSON_PAIR(F23, double) JSON_PAIR(F24, std::string)
+  JSON_PAIR(F25, int) JSON_PAIR(F26, double) JSON_PAIR(F27, std::string)
+  JSON_PAIR(F28, int) JSON_PAIR(F29, double) JSON_PAIR(F30, unsigned)
+JSON_OBJECT_PAIRS(Record30, F1, F2, F3, F4, F5, F6, F7, F8, F9, F10, F11, F12,
+  F13, F14, F15, F16, F17, F18, F19, F20, F21, F22, F23, F24, F25, F26, F27,
+  F28, F29, F30)
+JSON_OBJECT_END(Record30)
+JSON_DEFAULT_TRAITS(::, Record30)
+
+JSON_OBJECT_BEGIN(Document)
+  JSON_PAIR(Title, std::string)
+  JSON_PAIR(Author, std::string)
+  JSON_PAIR(Text, std::string)
+  JSON_PAIR(Tags, std::vector<std::string>)
+JSON_OBJECT_PAIRS(Document, Title, Author, Text, Tags)
+JSON_OBJECT_END(Document)
+JSON_DEFAULT_TRAITS(::, Document)
+
+/// Nested arrays with a specified depth.
+template<unsigned Depth> struct Nested {
+  using Type = std::vector<typename Nested<Depth - 1>::Type>;
+};
+template<> struct Nested<0> { using Type = int; };
+
+/// Initializes each cell in a record with some value.
+class InitCell {
+public:
+  explicit InitCell(std::size_t Seed) : mSeed(Seed) {}
+  template<class CellTy> void operator()(CellTy *C) {
+    init(C->template value<typename CellTy::CellKey>());
+  }
+private:
+  void init(int &V) { V = static_cast<int>(mSeed++ % 100000) - 50000; }
+  void init(unsigned &V) { V = static_cast<unsigned>(mSeed++ % 100000); }
+  void init(double &V) { V = (mSeed++ % 100000) / 64.0; }
+  void init(std::string &V) { V = "value " + std::to_string(mSeed++); }
+  std::size_t mSeed;
+};
+
+std::string randomText(std::size_t Size) {
+  static const char Alphabet[] = "abcdefghijklmnopqrstuvwxyz ";
+  std::string Text(Size, ' ');
+  for (auto &Ch : Text)
+    Ch = Alphabet[std::rand() % (sizeof(Alphabet) - 1)];
+  return Text;
+}
+
+template<unsigned Depth> struct BuildNested {
+  static typename Nested<Depth>::Type build(unsigned Fanout, int &Value) {
+    typename Nested<Depth>::Type Res;
+    for (unsigned I = 0; I < Fanout; ++I)
+      Res.push_back(BuildNested<Depth - 1>::build(Fanout, Value));
+    return Res;
+  }
+};
+template<> struct BuildNested<0> {
+  static int build(unsigned, int &Value) { return Value++; }
+};
+
+/// Throughput of a single operation.
+struct Result {
+  std::string Corpus;
+  std::string Operation;
+  std::size_t Bytes;
+  unsigned Iterations;
+  TimeT Time;
+};
+
+template<class Ty>
+void run(const std::string &Corpus, const Ty &Data, unsigned MaxIter,
+    std::vector<Result> &Results) {
+  TimeT UnparseT(0), ParseT(0), ValidateT(0);
+  json::String JSON;
+  for (unsigned I = 0; I < MaxIter; ++I) {
+    auto S = std::chrono::high_resolution_clock::now();
+    JSON = json::Parser<>::unparse(Data);
+    UnparseT += std::chrono::high_resolution_clock::now() - S;
+  }
+  for (unsigned I = 0; I < MaxIter; ++I) {
+    auto S = std::chrono::high_resolution_clock::now();
+    json::Parser<> P(JSON);
+    Ty Obj;
+    if (!P.parse(Obj)) {
+      std::cerr << "error: unable to parse " << Corpus << " corpus\n";
+      std::exit(3);
+    }
+    ParseT += std::chrono::high_resolution_clock::now() - S;
+  }
+  for (unsigned I = 0; I < MaxIter; ++I) {
+    auto S = std::chrono::high_resolution_clock::now();
+    json::Parser<> P(JSON);
+    if (!P.validate<Ty>()) {
+      std::cerr << "error: unable to validate " << Corpus << " corpus\n";
+      std::exit(3);
+    }
+    ValidateT += std::chrono::high_resolution_clock::now() - S;
+  }
+  Results.push_back(Result{Corpus, "unparse", JSON.size(), MaxIter, UnparseT});
+  Results.push_back(Result{Corpus, "parse", JSON.size(), MaxIter, ParseT});
+  Results.push_back(
+    Result{Corpus, "validate", JSON.size(), MaxIter, ValidateT});
+}
+
+template<class RecordT>
+std::vector<RecordT> records(std::size_t Size) {
+  std::vector<RecordT> Records(Size);
+  for (std::size_t I = 0; I < Size; ++I)
+    Records[I].for_each(InitCell(I));
+  return Records;
+}
+
+int main(int Argc, char **Argv) {
+  std::string Help = "parameters: <size of data> [number of iterations]\n";
+  if (Argc < 2) {
+    std::cerr << "error: too few arguments\n" << Help;
+    return 1;
+  } else if (Argc > 3) {
+    std::cerr << "error: too many arguments\n" << Help;
+    return 2;
+  }
+  std::size_t Size = std::atoll(Argv[1]);
+  unsigned MaxIter = (Argc > 2) ? std::atoi(Argv[2]) : 10;
+  std::vector<Result> Results;
+  {
+    std::vector<int> Ints(Size);
+    std::vector<double> Doubles(Size);
+    for (std::size_t I = 0; I < Size; ++I) {
+      Ints[I] = std::rand() - RAND_MAX / 2;
+      Doubles[I] = std::rand() / 1024.0;
+    }
+    run("int array", Ints, MaxIter, Results);
+    run("double array", Doubles, MaxIter, Results);
+  }
+  {
+    std::vector<Document> Docs(Size / 16 + 1);
+    for (auto &D : Docs) {
+      D[Document::Title] = randomText(32);
+      D[Document::Author] = randomText(16);
+      D[Document::Text] = randomText(512);
+      D[Document::Tags] = { randomText(8), randomText(8), randomText(8) };
+    }
+    run("strings", Docs, MaxIter, Results);
+  }
+  {
+    // Each nested array has 2^10 integers.
+    std::vector<Nested<10>::Type> Deep(Size / 1024 + 1);
+    int Value = 0;
+    for (auto &D : Deep)
+      D = BuildNested<10>::build(2, Value);
+    run("deep nesting", Deep, MaxIter, Results);
+  }
+  run("1 field records", records<Record1>(Size), MaxIter, Results);
+  run("10 field records", records<Record10>(Size / 10 + 1), MaxIter, Results);
+  run("30 field records", records<Record30>(Size / 30 + 1), MaxIter, Results);
+  std::cout << "Results for " << __FILE__ << " benchmark" << std::endl;
+  std::cout << "  date " << __DATE__ << std::endl;
+  std::cout << "  compiler ";
+#if defined __GNUC__
+  std::cout << "GCC " << __GNUC__;
+#elif defined __clang__
+  std::cout << "Clang " << __clang__;
+#elif defined _MSC_VER
+  std::cout << "Microsoft " << _MSC_VER;
+#else
+  std::cout << "unknown";
+#endif
+  std::cout << std::endl;
+  std::cout << "  BCL version " << BCL_VERSION_STRING << std::endl;
+  std::cout << "  size of data " << Size << std::endl;
+  std::cout << "  number of iterations " << MaxIter << std::endl;
+  std::cout << std::endl;
+  for (auto &R : Results)
+    std::cout << R.Corpus << " " << R.Operation << " throughput (MB/s) " <<
+      R.Bytes * R.Iterations / R.Time.count() / 1e6 << std::endl;
+  std::cout << std::endl;
+  std::cout << "csv,corpus,operation,bytes,iterations,seconds,MB/s\n";
+  for (auto &R : Results)
+    std::cout << "csv," << R.Corpus << "," << R.Operation << "," << R.Bytes <<
+      "," << R.Iterations << "," << R.Time.count() << "," <<
+      R.Bytes * R.Iterations / R.Time.count() / 1e6 << std::endl;
+  return 0;
+}
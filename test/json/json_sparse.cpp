@@ -0,0 +1,91 @@
+//===- json_sparse.cpp ------- JSON Sparse Array Test -------------*- C -*-===//
+//
+//                       Base Construction Library (BCL)
+//
+// Copyright 2018 Nikita Kataev
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements test for conversion of arrays which are represented
+// as {"0":V0, ..., "N":VN} to std::vector.
+//
+//===----------------------------------------------------------------------===//
+
+#include <bcl/bcl-config.h>
+#include <bcl/Json.h>
+#include <iostream>
+#include <vector>
+
+template<class Ty> bool check(const json::String &JSON, bool Expected,
+    const Ty &Result = Ty()) {
+  std::cout << "Parse " << JSON << ": ";
+  json::Parser<> P(JSON);
+  Ty Obj;
+  if (P.parse(Obj) != Expected || (Expected && Obj != Result)) {
+    std::cout << "fail" << std::endl;
+    for (auto Err : P.errors())
+      std::cout << "  " << Err << std::endl;
+    return false;
+  }
+  std::cout << "ok" << std::endl;
+  return true;
+}
+
+int main() {
+  std::cout << "BCL version " << BCL_VERSION_STRING << std::endl;
+  using Ints = std::vector<int>;
+  using Strings = std::vector<std::string>;
+  bool Ok = true;
+  Ok &= check<Ints>(R"j({})j", true, Ints{});
+  Ok &= check<Ints>(R"j({"1":2,"0":1,"2":3})j", true, Ints{1, 2, 3});
+  Ok &= check<Ints>(R"j({"0":1,"2":3})j", false);
+  Ok &= check<Ints>(R"j({"0":1,"0":3})j", false);
+  Ok &= check<Ints>(R"j({"999999999":1})j", false);
+  Ok &= check<Ints>(R"j({"99999999999999999999999":1})j", false);
+  Ok &= check<Ints>(R"j({"x":1})j", false);
+  Ok &= check<Ints>(R"j({"-1":1})j", false);
+  Ok &= check<Ints>(R"j({"0":1)j", false);
+  Ok &= check<std::vector<Ints>>(R"j({"1":{"1":4,"0":3},"0":[1,2]})j", true,
+    std::vector<Ints>{{1, 2}, {3, 4}});
+  Ok &= check<Strings>(R"j({"1":"b","0":"a"})j", true, Strings{"a", "b"});
+  std::vector<int *> Pointers{ nullptr, new int(5), nullptr, new int(7) };
+  auto JSON = json::Parser<>::unparse(Pointers);
+  std::cout << "Parse " << JSON << ": ";
+  json::Parser<> P(JSON);
+  std::vector<int *> Result;
+  if (!P.parse(Result) || Result.size() != 4 || Result[0] || Result[2] ||
+      !Result[1] || *Result[1] != 5 || !Result[3] || *Result[3] != 7) {
+    std::cout << "fail" << std::endl;
+    Ok = false;
+  } else {
+    std::cout << "ok" << std::endl;
+  }
+  Ok &= check<std::vector<int *>>(R"j({"999999999":1})j", false);
+  json::Parser<> V(R"j({"999999999":1})j");
+  if (V.validate<std::vector<int *>>()) {
+    std::cout << "Array of pointers with a large index is valid" << std::endl;
+    Ok = false;
+  }
+  json::Parser<> Q(JSON);
+  if (!Q.validate<std::vector<int *>>()) {
+    std::cout << "Unable to validate array of pointers" << std::endl;
+    Ok = false;
+  }
+  for (auto *Ptr : Pointers)
+    delete Ptr;
+  for (auto *Ptr : Result)
+    delete Ptr;
+  return Ok ? 0 : 1;
+}
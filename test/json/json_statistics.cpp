@@ -0,0 +1,107 @@
+//===- json_statistics.cpp ---- JSON Statistics Test --------------*- C -*-===//
+//
+//                       Base Construction Library (BCL)
+//
+// Copyright 2018 Nikita Kataev
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements test for statistics which are collected by json::Lexer
+// if BCL is configured with BCL_JSON_STATISTICS option. Otherwise, statistics
+// must be empty.
+//
+//===----------------------------------------------------------------------===//
+
+#include <bcl/bcl-config.h>
+#include <bcl/Json.h>
+#include <iostream>
+#include <map>
+#include <vector>
+
+JSON_OBJECT_BEGIN(Human)
+  JSON_PAIR(Name, std::string)
+JSON_OBJECT_ROOT_PAIRS(Human, Name)
+  Human() : JSON_INIT_ROOT {}
+JSON_OBJECT_END(Human)
+JSON_DEFAULT_TRAITS(::, Human)
+
+void print(const json::Statistics &S) {
+  std::cout << "  tokens " << S.Tokens << ", skipped bytes " <<
+    S.SkippedBytes << ", key scans " << S.KeyScans << ", rewinds " <<
+    S.Rewinds << ", allocations " << S.Allocations << ", errors " <<
+    S.Errors << std::endl;
+}
+
+bool check(const char *What, bool Ok, const json::Statistics &S) {
+#ifndef BCL_JSON_STATISTICS
+  Ok = S.Tokens == 0 && S.SkippedBytes == 0 && S.KeyScans == 0 &&
+    S.Rewinds == 0 && S.Allocations == 0 && S.Errors == 0;
+#endif
+  std::cout << What << ": " << (Ok ? "ok" : "fail") << std::endl;
+  if (!Ok)
+    print(S);
+  return Ok;
+}
+
+int main() {
+  std::cout << "BCL version " << BCL_VERSION_STRING << std::endl;
+  bool Ok = true;
+  {
+    json::Parser<> P("[1,2,3]");
+    std::vector<int> V;
+    P.parse(V);
+    auto S = P.statistics();
+    Ok &= check("Scan of array", S.KeyScans == 1 && S.Rewinds == 0 &&
+      S.Allocations == 1 && S.Errors == 0 && S.Tokens == 7, S);
+  }
+  {
+    json::Parser<> P("[[[1],[2,3]],[[4]]]");
+    std::vector<std::vector<std::vector<int>>> V;
+    P.parse(V);
+    auto S = P.statistics();
+    Ok &= check("Scan of nested arrays", S.KeyScans == 1 && S.Rewinds == 0 &&
+      S.Allocations == 6 && S.Errors == 0 && S.Tokens == 19, S);
+  }
+  {
+    json::Parser<> P("[1,2,3]");
+    P.buildTape();
+    std::vector<int> V;
+    P.parse(V);
+    auto S = P.statistics();
+    Ok &= check("Array with tape", S.KeyScans == 0 && S.Rewinds == 0 &&
+      S.Allocations == 1 && S.Tokens == 7, S);
+  }
+  {
+    json::Parser<> P(R"j({"a":1,"b":2})j");
+    std::map<std::string, int> M;
+    P.parse(M);
+    auto S = P.statistics();
+    Ok &= check("Map", S.Rewinds == 2 && S.Allocations == 2, S);
+  }
+  {
+    json::Parser<Human> P(R"j({"name":"Human","Pets":{"Rex":[1,{}]}})j");
+    P.parse();
+    auto S = P.statistics();
+    Ok &= check("Skip of unknown value", S.SkippedBytes == 14, S);
+  }
+  {
+    json::Parser<> P(R"j([1,"x"])j");
+    std::vector<int> V;
+    P.parse(V);
+    auto S = P.statistics();
+    Ok &= check("Error", S.Errors == P.errors().size() && S.Errors > 0, S);
+  }
+  return Ok ? 0 : 1;
+}
@@ -0,0 +1,97 @@
+//===- json_tape.cpp ------ JSON Structural Index Test ------------*- C -*-===//
+//
+//                       Base Construction Library (BCL)
+//
+// Copyright 2018 Nikita Kataev
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements test for json::Tape and its usage in json::Parser.
+//
+//===----------------------------------------------------------------------===//
+
+#include <bcl/bcl-config.h>
+#include <bcl/Json.h>
+#include <iostream>
+
+JSON_OBJECT_BEGIN(Human)
+JSON_OBJECT_ROOT_PAIR_3(Human,
+  Name, std::string, Age, unsigned, Kids, std::vector<std::vector<std::string>>)
+  Human() : JSON_INIT_ROOT {}
+JSON_OBJECT_END(Human)
+JSON_DEFAULT_TRAITS(::, Human)
+
+int main() {
+  std::cout << "BCL version " << BCL_VERSION_STRING << std::endl;
+  json::String JSON(R"j({"name":"Human", "Kids": [[1, 2], [], ["]"]],)j"
+    R"j( "Name": "{Jon}", "Age": 7})j");
+  json::Tape T(JSON);
+  if (!T.isValid() || T.size() != 5) {
+    std::cout << "Unable to build tape for a correct string" << std::endl;
+    return 1;
+  }
+  std::size_t Hint = 0;
+  auto *E = T.find(JSON.find('['), Hint);
+  if (!E || JSON[E->Close] != ']' || E->Size != 3 ||
+      JSON.compare(E->Close + 1, 2, ", ") != 0) {
+    std::cout << "Wrong description of an array" << std::endl;
+    return 2;
+  }
+  if (json::Tape(R"j({"a":[1, 2})j").isValid() ||
+      json::Tape(R"j({"a":"1})j").isValid()) {
+    std::cout << "Tape is built for a malformed string" << std::endl;
+    return 3;
+  }
+  json::Parser<Human> P(JSON);
+  if (!P.buildTape()) {
+    std::cout << "Unable to build tape in a parser" << std::endl;
+    return 4;
+  }
+  for (unsigned I = 0; I < 2; ++I) {
+    Human H;
+    if (!P.parse(H) || H[Human::Name] != "{Jon}" || H[Human::Age] != 7 ||
+        H[Human::Kids].size() != 3 || H[Human::Kids][0].size() != 2 ||
+        !H[Human::Kids][1].empty() || H[Human::Kids][2][0] != "]") {
+      for (auto Err : P.errors())
+        std::cout << Err << std::endl;
+      return 5;
+    }
+  }
+  json::Parser<Human> Shared(JSON, P.tape());
+  auto O = Shared.parse();
+  if (!O || !O->is<Human>() || O->as<Human>()[Human::Age] != 7) {
+    std::cout << "Unable to parse string with a shared tape" << std::endl;
+    return 6;
+  }
+  json::Tape Value;
+  auto Open = JSON.find('[');
+  if (!Value.build(JSON, Open) || Value.size() != 4 ||
+      Value.begin()->Open != Open || Value.begin()->Size != 3 ||
+      Value.build(JSON, Open - 1) || Value.isValid() ||
+      Value.build(R"j({"a":[1, [2})j", 5)) {
+    std::cout << "Wrong tape of a single value" << std::endl;
+    return 7;
+  }
+  json::Parser<Human> WithoutTape(JSON);
+  Human H;
+  if (!WithoutTape.parse(H) || H[Human::Kids].size() != 3 ||
+      H[Human::Kids][0].size() != 2 || H[Human::Kids][2][0] != "]") {
+    std::cout << "Unable to parse string with an index of a value" <<
+      std::endl;
+    return 8;
+  }
+  std::cout << "Structural index is correct" << std::endl;
+  return 0;
+}
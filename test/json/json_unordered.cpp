@@ -0,0 +1,88 @@
+//===- json_unordered.cpp ---- JSON Hash Containers Test -----------*- C -*-===//
+//
+//                       Base Construction Library (BCL)
+//
+// Copyright 2018 Nikita Kataev
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements test for conversion of std::unordered_map and
+// std::unordered_set and for json::Parser<>::numberOfElements().
+//
+//===----------------------------------------------------------------------===//
+
+#include <bcl/bcl-config.h>
+#include <bcl/Json.h>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+bool checkNumberOfElements(const json::String &JSON, json::Position Expected) {
+  std::cout << "Count elements in " << JSON << ": ";
+  json::Lexer Lex(JSON);
+  Lex.goToNext();
+  auto Count = json::Parser<>::numberOfElements(Lex);
+  json::Lexer TapeLex(JSON);
+  TapeLex.buildTape();
+  TapeLex.goToNext();
+  auto TapeCount = json::Parser<>::numberOfElements(TapeLex);
+  if (Count != Expected || TapeCount != Expected) {
+    std::cout << "fail (" << Count << ", " << TapeCount << ")" << std::endl;
+    return false;
+  }
+  std::cout << "ok" << std::endl;
+  return true;
+}
+
+int main() {
+  std::cout << "BCL version " << BCL_VERSION_STRING << std::endl;
+  bool Ok = true;
+  Ok &= checkNumberOfElements("[]", 0);
+  Ok &= checkNumberOfElements("{ }", 0);
+  Ok &= checkNumberOfElements("[1]", 1);
+  Ok &= checkNumberOfElements(R"j({"a":[1,2],"b":"x,y","c":{"d":1}})j", 3);
+  Ok &= checkNumberOfElements("1", 0);
+  typedef std::unordered_map<std::string, std::vector<int>> MapTy;
+  MapTy M;
+  for (int I = 0; I < 1000; ++I)
+    M[std::to_string(I)] = std::vector<int>(I % 3, I);
+  auto JSON = json::Parser<>::unparse(M);
+  json::Parser<> P(JSON);
+  MapTy Parsed;
+  if (!P.parse(Parsed) || Parsed != M) {
+    std::cout << "Unable to parse unordered map" << std::endl;
+    Ok = false;
+  }
+  std::unordered_set<unsigned> S{ 5, 1, 3, 7 };
+  json::Parser<> SP(json::Parser<>::unparse(S));
+  std::unordered_set<unsigned> ParsedS;
+  if (!SP.parse(ParsedS) || ParsedS != S) {
+    std::cout << "Unable to parse unordered set" << std::endl;
+    Ok = false;
+  }
+  json::Parser<> Dup("[1,2,1]");
+  if (Dup.parse(ParsedS)) {
+    std::cout << "Duplicate element has been parsed" << std::endl;
+    Ok = false;
+  }
+  json::Parser<> DupKey(R"j({"a":[],"a":[1]})j");
+  if (DupKey.parse(Parsed)) {
+    std::cout << "Duplicate key has been parsed" << std::endl;
+    Ok = false;
+  }
+  return Ok ? 0 : 1;
+}
@@ -0,0 +1,122 @@
+//===- json_validate.cpp ---- JSON Validation Test -----------------*- C -*-===//
+//
+//                       Base Construction Library (BCL)
+//
+// Copyright 2018 Nikita Kataev
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements test for json::Parser<...>::validate() which checks
+// JSON strings without conversion of values.
+//
+//===----------------------------------------------------------------------===//
+
+#include <bcl/bcl-config.h>
+#include <bcl/Json.h>
+#include <iostream>
+#include <map>
+
+JSON_OBJECT_BEGIN(Human)
+JSON_OBJECT_ROOT_PAIR_3(Human,
+  Name, std::string, Age, unsigned, Kids, std::vector<std::string>)
+  Human() : JSON_INIT_ROOT {}
+JSON_OBJECT_END(Human)
+JSON_DEFAULT_TRAITS(::, Human)
+
+/// Value which counts number of its conversions.
+struct Probe { int Value; };
+static int NumberOfParsedProbes = 0;
+
+namespace json {
+template<> struct Traits<Probe> {
+  static bool parse(Probe &Dest, Lexer &Lex) {
+    ++NumberOfParsedProbes;
+    return Traits<int>::parse(Dest.Value, Lex);
+  }
+  static bool validate(Lexer &Lex) {
+    int Tmp;
+    return Traits<int>::parse(Tmp, Lex);
+  }
+  static void unparse(String &JSON, const Probe &Obj) {
+    Traits<int>::unparse(JSON, Obj.Value);
+  }
+};
+}
+
+bool check(const json::String &JSON, bool Expected) {
+  std::cout << "Validate " << JSON << ": ";
+  json::Parser<Human> P(JSON);
+  if (P.validate() != Expected) {
+    std::cout << "fail" << std::endl;
+    for (auto Err : P.errors())
+      std::cout << "  " << Err << std::endl;
+    return false;
+  }
+  std::cout << "ok" << std::endl;
+  return true;
+}
+
+template<class Ty> bool check(const json::String &JSON, bool Expected) {
+  std::cout << "Validate " << JSON << ": ";
+  json::Parser<> P(JSON);
+  if (P.validate<Ty>() != Expected) {
+    std::cout << "fail" << std::endl;
+    for (auto Err : P.errors())
+      std::cout << "  " << Err << std::endl;
+    return false;
+  }
+  std::cout << "ok" << std::endl;
+  return true;
+}
+
+int main() {
+  std::cout << "BCL version " << BCL_VERSION_STRING << std::endl;
+  bool Ok = true;
+  Ok &= check(R"j({"name":"Human","Name":"Jon","Age":1})j", true);
+  Ok &= check(R"j({"name":"Human","Kids":["Ann","Bob"]})j", true);
+  Ok &= check(R"j({"name":"Human","Kids":{"1":"Bob","0":"Ann"}})j", true);
+  Ok &= check(R"j({"name":"Human","Kids":{"0":"Ann","2":"Bob"}})j", false);
+  Ok &= check(R"j({"name":"Human","Kids":{"0":"Ann","0":"Bob"}})j", false);
+  Ok &= check(R"j({"name":"Human","Kids":[["Ann"]]})j", false);
+  Ok &= check(R"j({"name":"Human","Age":"old"})j", false);
+  Ok &= check(R"j({"name":"Human","Name":"Jon"},)j", false);
+  Ok &= check(R"j({"name":"Cat","Name":"Tom"})j", false);
+  Ok &= check(R"j({"name":"Human","Pets":{"Rex":[1,{}]},"Age":1})j", true);
+  Ok &= check<std::map<std::string, std::vector<int>>>(
+    R"j({"a":[1,2],"b":[]})j", true);
+  Ok &= check<std::map<std::string, std::vector<int>>>(
+    R"j({"a":[1,"x"]})j", false);
+  Ok &= check<std::map<int, int>>(R"j({"1":1,"x":2})j", false);
+  Ok &= check<std::set<unsigned>>(R"j([1,2,3])j", true);
+  Ok &= check<std::set<unsigned>>(R"j({"0":1})j", false);
+  Ok &= check<const char *>(R"j("text")j", true);
+  Ok &= check<int *>(R"j([1,2,"x"])j", false);
+  Ok &= check<std::vector<Probe>>(R"j([1,2,3])j", true);
+  Ok &= check<std::vector<Probe>>(R"j([1,{}])j", false);
+  Ok &= check<bcl::Diagnostic>(R"j(["error C1(5): message"])j", true);
+  Ok &= check<bcl::Diagnostic>(R"j(["error: message"])j", false);
+  if (NumberOfParsedProbes != 0) {
+    std::cout << "Values have been converted during validation" << std::endl;
+    Ok = false;
+  }
+  json::Parser<Human> P(
+    R"j({"name":"Human","Pets":{"Rex":[1,{}]},"Name":"Jon"})j");
+  auto O = P.parse();
+  if (!O || O->as<Human>()[Human::Name] != "Jon") {
+    std::cout << "Unable to skip a value of unknown key" << std::endl;
+    Ok = false;
+  }
+  return Ok ? 0 : 1;
+}
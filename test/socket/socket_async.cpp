@@ -0,0 +1,171 @@
+//===- socket_async.cpp ---- Asynchronous Sending Test ------------*- C -*-===//
+//
+//                       Base Construction Library (BCL)
+//
+// Copyright 2018 Nikita Kataev
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements test for asynchronous sending of messages to a slow
+// client. Watermarks of an output buffer must be reported and each overflow
+// policy must be applied when the output buffer is full.
+//
+//===----------------------------------------------------------------------===//
+
+#include <bcl/bcl-config.h>
+#include "socket_test.h"
+#include <iostream>
+
+using namespace bcl;
+
+namespace {
+constexpr unsigned MessageNumber = 64;
+constexpr std::size_t MessageSize = 1 << 16;
+constexpr unsigned ReadNumber = 4;
+
+std::string message(unsigned I) {
+  auto Prefix = std::to_string(I) + ":";
+  return Prefix + std::string(MessageSize - Prefix.size(), 'x');
+}
+}
+
+namespace bcl {
+template<> void createServer<std::string>(const Socket<std::string> *S) {
+  S->receive([S](const std::string &M) {
+    if (M == "flood")
+      for (unsigned I = 0; I < MessageNumber; ++I)
+        S->send(message(I));
+    else
+      S->send("echo:" + M);
+  });
+}
+}
+
+/// Reads messages until the connection is idle, checks that messages are
+/// received in order starting from a specified one and returns the number of
+/// received messages.
+static bool drain(test::Client &C, unsigned First, unsigned &Number) {
+  Number = 0;
+  int Last = static_cast<int>(First) - 1;
+  while (C.poll(std::chrono::milliseconds(300))) {
+    std::string M;
+    if (!C.receive(net::FramingMode::LengthPrefix, M))
+      return true;
+    auto I = std::stoi(M);
+    if (I <= Last || M != message(I))
+      return false;
+    Last = I;
+    ++Number;
+  }
+  return true;
+}
+
+static bool check(const char *Name, net::OverflowPolicy Overflow) {
+  std::cout << "Overflow policy " << Name << ": ";
+  net::ServerOptions Options;
+  Options.Mode = net::ServerMode::EventLoop;
+  // A blocked listener occupies a worker, so the second worker executes
+  // listeners of other connections.
+  Options.WorkerNumber = 2;
+  Options.Framing = net::FramingMode::LengthPrefix;
+  Options.IsAsyncSend = true;
+  Options.Overflow = Overflow;
+  Options.OutputMaxSize = 1 << 20;
+  Options.OutputHighWatermark = 1 << 18;
+  Options.OutputLowWatermark = 1 << 16;
+  // Keep data in the output buffer instead of the system buffer.
+  Options.SendBufferSize = 1 << 14;
+  auto &Log = *new test::StatusLog;
+  auto Address = test::unixAddress(std::string("async-") + Name);
+  net::PortT Port;
+  if (!test::runServer(Address, Options, Log, Port)) {
+    std::cout << "unable to start server" << std::endl;
+    return false;
+  }
+  test::Client C;
+  if (!C.connect(Address, Port) ||
+      !C.send(net::FramingMode::LengthPrefix, "flood")) {
+    std::cout << "unable to send" << std::endl;
+    return false;
+  }
+  if (!Log.wait(net::SocketStatus::SendHighWatermark)) {
+    std::cout << "high watermark is not reported" << std::endl;
+    return false;
+  }
+  // Wait until the output buffer is full.
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  std::string Reply;
+  if (Overflow == net::OverflowPolicy::Block) {
+    // Read slowly, so the event loop writes buffered data when the socket
+    // becomes writable, while the listener is still blocked.
+    for (unsigned I = 0; I < ReadNumber; ++I) {
+      if (!C.receive(net::FramingMode::LengthPrefix, Reply) ||
+          Reply != message(I)) {
+        std::cout << "unexpected message" << std::endl;
+        return false;
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+  }
+  // Other connections of the same event loop are still served.
+  test::Client Other;
+  if (!Other.connect(Address, Port) ||
+      !Other.send(net::FramingMode::LengthPrefix, "other") ||
+      !Other.receive(net::FramingMode::LengthPrefix, Reply) ||
+      Reply != "echo:other") {
+    std::cout << "event loop is blocked" << std::endl;
+    return false;
+  }
+  unsigned Number;
+  switch (Overflow) {
+  case net::OverflowPolicy::Block:
+    if (!drain(C, ReadNumber, Number) ||
+        Number != MessageNumber - ReadNumber) {
+      std::cout << "messages are lost" << std::endl;
+      return false;
+    }
+    break;
+  case net::OverflowPolicy::Drop:
+    if (!Log.wait(net::SocketStatus::SendDrop) || !drain(C, 0, Number) ||
+        Number == 0 || Number == MessageNumber) {
+      std::cout << "messages are not dropped" << std::endl;
+      return false;
+    }
+    break;
+  case net::OverflowPolicy::Close:
+    if (!Log.wait(net::SocketStatus::SendError) || !C.waitClosed()) {
+      std::cout << "connection is not closed" << std::endl;
+      return false;
+    }
+    break;
+  }
+  if (Overflow != net::OverflowPolicy::Close &&
+      !Log.wait(net::SocketStatus::SendLowWatermark)) {
+    std::cout << "low watermark is not reported" << std::endl;
+    return false;
+  }
+  test::removeUnixAddress(Address);
+  std::cout << "ok" << std::endl;
+  return true;
+}
+
+int main() {
+  std::cout << "BCL version " << BCL_VERSION_STRING << std::endl;
+  bool Ok = true;
+  Ok &= check("block", net::OverflowPolicy::Block);
+  Ok &= check("drop", net::OverflowPolicy::Drop);
+  Ok &= check("close", net::OverflowPolicy::Close);
+  return Ok ? 0 : 1;
+}
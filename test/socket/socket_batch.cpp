@@ -0,0 +1,147 @@
+//===- socket_batch.cpp ---- Batch Sending Test -------------------*- C -*-===//
+//
+//                       Base Construction Library (BCL)
+//
+// Copyright 2018 Nikita Kataev
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements test for sending of messages from listeners. Messages
+// are sent immediately unless batching is enabled, batched messages are sent
+// when a listener returns or when the batch size limit is exceeded.
+//
+//===----------------------------------------------------------------------===//
+
+#include <bcl/bcl-config.h>
+#include "socket_test.h"
+#include <iostream>
+#include <memory>
+
+using namespace bcl;
+
+namespace {
+// Listeners may be executed when the test exits, so this state is never
+// destroyed.
+std::mutex &GateMutex = *new std::mutex;
+std::condition_variable &GateChanged = *new std::condition_variable;
+bool IsGateOpen = false;
+
+void openGate(bool IsOpen) {
+  std::lock_guard<std::mutex> Lock(GateMutex);
+  IsGateOpen = IsOpen;
+  GateChanged.notify_all();
+}
+}
+
+namespace bcl {
+template<> void createServer<std::string>(const Socket<std::string> *S) {
+  S->receive([S](const std::string &M) {
+    if (M == "progress") {
+      S->send("started");
+      std::unique_lock<std::mutex> Lock(GateMutex);
+      GateChanged.wait_for(Lock, test::Timeout, []() { return IsGateOpen; });
+      Lock.unlock();
+      S->send("finished");
+    } else if (M == "burst") {
+      for (unsigned I = 0; I < 10; ++I)
+        S->send(I == 5 ? std::string(1000, 'x') : std::to_string(I));
+    }
+  });
+}
+}
+
+/// Connects a client which stores received messages in an inbox.
+static std::shared_ptr<const net::ViewSocket> connect(std::size_t BatchSize,
+    const std::shared_ptr<test::Inbox> &Client) {
+  net::ServerOptions Options;
+  Options.Framing = net::FramingMode::LengthPrefix;
+  Options.BatchSize = BatchSize;
+  return net::connectLocal([Client](const net::ViewSocket *S) {
+    S->receive([Client](const std::string &M) { Client->push(M); });
+  }, Options);
+}
+
+static bool checkProgress(std::size_t BatchSize) {
+  std::cout << "Send progress (batch size " << BatchSize << "): ";
+  openGate(false);
+  auto Client = std::make_shared<test::Inbox>();
+  auto S = connect(BatchSize, Client);
+  if (!S) {
+    std::cout << "unable to connect" << std::endl;
+    return false;
+  }
+  S->send("progress");
+  // A message is sent at once unless batching is enabled.
+  bool IsStarted;
+  {
+    std::unique_lock<std::mutex> Lock(Client->Mutex);
+    IsStarted = Client->Changed.wait_for(Lock,
+      std::chrono::milliseconds(BatchSize == 0 ? 5000 : 200),
+      [&Client]() { return !Client->Messages.empty(); });
+  }
+  openGate(true);
+  if (IsStarted != (BatchSize == 0)) {
+    std::cout << (IsStarted ? "message is not batched" :
+                  "message is delayed") << std::endl;
+    return false;
+  }
+  if (!Client->waitMessages(2)) {
+    std::cout << "timeout" << std::endl;
+    return false;
+  }
+  std::lock_guard<std::mutex> Lock(Client->Mutex);
+  if (Client->Messages[0] != "started" || Client->Messages[1] != "finished") {
+    std::cout << "unexpected messages" << std::endl;
+    return false;
+  }
+  std::cout << "ok" << std::endl;
+  return true;
+}
+
+static bool checkBurst(std::size_t BatchSize) {
+  std::cout << "Send burst (batch size " << BatchSize << "): ";
+  auto Client = std::make_shared<test::Inbox>();
+  auto S = connect(BatchSize, Client);
+  if (!S) {
+    std::cout << "unable to connect" << std::endl;
+    return false;
+  }
+  S->send("burst");
+  if (!Client->waitMessages(10)) {
+    std::cout << "timeout" << std::endl;
+    return false;
+  }
+  std::lock_guard<std::mutex> Lock(Client->Mutex);
+  for (unsigned I = 0; I < 10; ++I)
+    if (Client->Messages[I] !=
+        (I == 5 ? std::string(1000, 'x') : std::to_string(I))) {
+      std::cout << "unexpected message " << I << std::endl;
+      return false;
+    }
+  std::cout << "ok" << std::endl;
+  return true;
+}
+
+int main() {
+  std::cout << "BCL version " << BCL_VERSION_STRING << std::endl;
+  bool Ok = true;
+  Ok &= checkProgress(0);
+  Ok &= checkProgress(4096);
+  Ok &= checkBurst(0);
+  // Messages are flushed when the batch size limit is exceeded.
+  Ok &= checkBurst(16);
+  Ok &= checkBurst(4096);
+  return Ok ? 0 : 1;
+}
@@ -0,0 +1,145 @@
+//===- socket_event_loop.cpp - Event Loop Server Test -------------*- C -*-===//
+//
+//                       Base Construction Library (BCL)
+//
+// Copyright 2018 Nikita Kataev
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements test for a C socket server in different modes. The
+// server echoes received messages to multiple concurrent clients. A client
+// which does not receive data must not stall other clients.
+//
+//===----------------------------------------------------------------------===//
+
+#include <bcl/bcl-config.h>
+#include "socket_test.h"
+#include <iostream>
+#include <memory>
+
+using namespace bcl;
+
+namespace bcl {
+template<> void createServer<std::string>(const Socket<std::string> *S) {
+  S->receive([S](const std::string &M) {
+    if (M == "flood")
+      for (unsigned I = 0; I < 64; ++I)
+        S->send(std::string(1 << 16, 'x'));
+    else
+      S->send("echo:" + M);
+  });
+}
+}
+
+static bool check(const char *Name, const net::AddressT &Address,
+    net::ServerMode Mode, bool IsAsyncSend = true) {
+  std::cout << "Echo " << Name << ": ";
+  net::ServerOptions Options;
+  Options.Mode = Mode;
+  Options.EventLoopNumber = 2;
+  Options.IsAsyncSend = IsAsyncSend;
+  Options.Framing = net::FramingMode::Delimiter;
+  auto &Log = *new test::StatusLog;
+  net::PortT Port;
+  if (!test::runServer(Address, Options, Log, Port)) {
+    std::cout << "unable to start server" << std::endl;
+    return false;
+  }
+  constexpr std::size_t ClientNumber = 4;
+  constexpr std::size_t MessageNumber = 3;
+  std::vector<std::unique_ptr<test::Client>> Clients;
+  for (std::size_t I = 0; I < ClientNumber; ++I) {
+    Clients.emplace_back(new test::Client);
+    if (!Clients.back()->connect(Address, Port)) {
+      std::cout << "unable to connect" << std::endl;
+      return false;
+    }
+  }
+  // Messages of different clients are interleaved.
+  for (std::size_t M = 0; M < MessageNumber; ++M)
+    for (std::size_t I = 0; I < ClientNumber; ++I)
+      if (!Clients[I]->send(net::FramingMode::Delimiter,
+            std::to_string(I) + "-" + std::to_string(M))) {
+        std::cout << "unable to send" << std::endl;
+        return false;
+      }
+  for (std::size_t I = 0; I < ClientNumber; ++I)
+    for (std::size_t M = 0; M < MessageNumber; ++M) {
+      std::string Message;
+      if (!Clients[I]->receive(net::FramingMode::Delimiter, Message) ||
+          Message != "echo:" + std::to_string(I) + "-" + std::to_string(M)) {
+        std::cout << "unexpected message to client " << I << std::endl;
+        return false;
+      }
+    }
+  Clients.clear();
+  if (!Log.wait(net::SocketStatus::Close, ClientNumber)) {
+    std::cout << "connections are not closed" << std::endl;
+    return false;
+  }
+  if (Log.count(net::SocketStatus::Accept) != ClientNumber) {
+    std::cout << "unexpected number of accepted connections" << std::endl;
+    return false;
+  }
+  std::cout << "ok" << std::endl;
+  return true;
+}
+
+/// Checks that a peer which does not receive data does not stall other
+/// connections of the same event loop with default options.
+static bool checkSlowPeer(const net::AddressT &Address) {
+  std::cout << "Serve connections while a peer does not receive data: ";
+  net::ServerOptions Options;
+  Options.Mode = net::ServerMode::EventLoop;
+  Options.Framing = net::FramingMode::Delimiter;
+  auto &Log = *new test::StatusLog;
+  net::PortT Port;
+  if (!test::runServer(Address, Options, Log, Port)) {
+    std::cout << "unable to start server" << std::endl;
+    return false;
+  }
+  test::Client Slow, Other;
+  std::string Message;
+  if (!Slow.connect(Address, Port) ||
+      !Slow.send(net::FramingMode::Delimiter, "flood") ||
+      !Log.wait(net::SocketStatus::SendHighWatermark) ||
+      !Other.connect(Address, Port) ||
+      !Other.send(net::FramingMode::Delimiter, "other") ||
+      !Other.receive(net::FramingMode::Delimiter, Message) ||
+      Message != "echo:other") {
+    std::cout << "event loop is blocked" << std::endl;
+    return false;
+  }
+  std::cout << "ok" << std::endl;
+  return true;
+}
+
+int main() {
+  std::cout << "BCL version " << BCL_VERSION_STRING << std::endl;
+  auto Unix = test::unixAddress("event-loop");
+  bool Ok = true;
+  Ok &= check("thread per connection", "127.0.0.1",
+    net::ServerMode::ThreadPerConnection);
+  Ok &= check("event loop", "127.0.0.1", net::ServerMode::EventLoop);
+  Ok &= check("event loop (Unix domain socket)", Unix,
+    net::ServerMode::EventLoop);
+  test::removeUnixAddress(Unix);
+  Ok &= check("event loop (synchronous sending)", Unix,
+    net::ServerMode::EventLoop, false);
+  test::removeUnixAddress(Unix);
+  Ok &= checkSlowPeer(Unix);
+  test::removeUnixAddress(Unix);
+  return Ok ? 0 : 1;
+}
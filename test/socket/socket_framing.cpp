@@ -0,0 +1,120 @@
+//===- socket_framing.cpp ---- Message Framing Test ---------------*- C -*-===//
+//
+//                       Base Construction Library (BCL)
+//
+// Copyright 2018 Nikita Kataev
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements test for splitting of a received stream of bytes into
+// messages. Messages are split into chunks and merged arbitrarily, messages
+// which exceed the size limit close a connection.
+//
+//===----------------------------------------------------------------------===//
+
+#include <bcl/bcl-config.h>
+#include "socket_test.h"
+#include <iostream>
+
+using namespace bcl;
+
+namespace bcl {
+template<> void createServer<std::string>(const Socket<std::string> *S) {
+  S->receive([S](const std::string &M) { S->send("echo:" + M); });
+}
+}
+
+/// Checks that a server echoes specified messages.
+static bool echo(test::Client &C, net::FramingMode Framing,
+    const std::vector<std::string> &Messages) {
+  for (auto &M : Messages) {
+    std::string Reply;
+    if (!C.receive(Framing, Reply, "\r\n") || Reply != "echo:" + M)
+      return false;
+  }
+  return true;
+}
+
+static bool check(const char *Name, net::ServerMode Mode,
+    net::FramingMode Framing) {
+  std::cout << "Split " << Name << ": ";
+  net::ServerOptions Options;
+  Options.Mode = Mode;
+  Options.Framing = Framing;
+  Options.Delimiter = "\r\n";
+  // Messages do not fit into a single chunk of data.
+  Options.BufferSize = 16;
+  Options.MaxMessageSize = 200;
+  auto &Log = *new test::StatusLog;
+  static unsigned ServerNumber = 0;
+  auto Address =
+    test::unixAddress("framing-" + std::to_string(ServerNumber++));
+  net::PortT Port;
+  if (!test::runServer(Address, Options, Log, Port)) {
+    std::cout << "unable to start server" << std::endl;
+    return false;
+  }
+  test::Client C;
+  if (!C.connect(Address, Port)) {
+    std::cout << "unable to connect" << std::endl;
+    return false;
+  }
+  // Send each byte separately, so delimiters and prefixes are split.
+  auto Data = test::Client::frame(Framing, "split", "\r\n");
+  for (auto Byte : Data) {
+    if (!C.send(std::string(1, Byte))) {
+      std::cout << "unable to send" << std::endl;
+      return false;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  if (!echo(C, Framing, {"split"})) {
+    std::cout << "split message is corrupted" << std::endl;
+    return false;
+  }
+  // Send multiple messages at once.
+  std::vector<std::string> Messages{
+    "first", "", std::string(150, 'x'), "\r", "last"};
+  Data.clear();
+  for (auto &M : Messages)
+    Data += test::Client::frame(Framing, M, "\r\n");
+  if (!C.send(Data) || !echo(C, Framing, Messages)) {
+    std::cout << "merged messages are corrupted" << std::endl;
+    return false;
+  }
+  // A message which exceeds the limit closes the connection.
+  if (!C.send(test::Client::frame(Framing, std::string(300, 'y'), "\r\n")) ||
+      !C.waitClosed() || !Log.wait(net::SocketStatus::ReceiveError)) {
+    std::cout << "large message does not close connection" << std::endl;
+    return false;
+  }
+  test::removeUnixAddress(Address);
+  std::cout << "ok" << std::endl;
+  return true;
+}
+
+int main() {
+  std::cout << "BCL version " << BCL_VERSION_STRING << std::endl;
+  bool Ok = true;
+  Ok &= check("delimited messages (threads)",
+    net::ServerMode::ThreadPerConnection, net::FramingMode::Delimiter);
+  Ok &= check("delimited messages (event loop)",
+    net::ServerMode::EventLoop, net::FramingMode::Delimiter);
+  Ok &= check("length-prefixed messages (threads)",
+    net::ServerMode::ThreadPerConnection, net::FramingMode::LengthPrefix);
+  Ok &= check("length-prefixed messages (event loop)",
+    net::ServerMode::EventLoop, net::FramingMode::LengthPrefix);
+  return Ok ? 0 : 1;
+}
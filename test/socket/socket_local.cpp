@@ -0,0 +1,186 @@
+//===- socket_local.cpp ---- In-Process Socket Test ---------------*- C -*-===//
+//
+//                       Base Construction Library (BCL)
+//
+// Copyright 2018 Nikita Kataev
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements test for a C socket server which is connected with
+// a client in the same process. The server echoes received messages.
+//
+//===----------------------------------------------------------------------===//
+
+#include <bcl/bcl-config.h>
+#include <bcl/CSocket.h>
+#include <chrono>
+#include <condition_variable>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace {
+/// Messages which are received by one side of a connection.
+struct Inbox {
+  std::mutex Mutex;
+  std::condition_variable Changed;
+  std::vector<std::string> Messages;
+  unsigned ClosedNumber = 0;
+
+  void push(std::string M) {
+    std::lock_guard<std::mutex> Lock(Mutex);
+    Messages.push_back(std::move(M));
+    Changed.notify_all();
+  }
+
+  void close() {
+    std::lock_guard<std::mutex> Lock(Mutex);
+    ++ClosedNumber;
+    Changed.notify_all();
+  }
+
+  /// Waits until a specified number of messages are received.
+  bool waitMessages(std::size_t Number) {
+    std::unique_lock<std::mutex> Lock(Mutex);
+    return Changed.wait_for(Lock, std::chrono::seconds(5),
+      [this, Number]() { return Messages.size() >= Number; });
+  }
+
+  /// Waits until a specified number of connections are closed.
+  bool waitClosed(unsigned Number) {
+    std::unique_lock<std::mutex> Lock(Mutex);
+    return Changed.wait_for(Lock, std::chrono::seconds(5),
+      [this, Number]() { return ClosedNumber >= Number; });
+  }
+};
+
+// Connections may be closed when the test exits, so the server inbox is
+// never destroyed.
+Inbox &ServerInbox = *new Inbox;
+}
+
+namespace bcl {
+template<> void createServer<std::string>(const Socket<std::string> *S) {
+  S->receive([S](const std::string &M) {
+    ServerInbox.push(M);
+    S->send("echo:" + M);
+  });
+  S->closed([](bool) { ServerInbox.close(); });
+}
+}
+
+static bool check(const char *Name, bcl::net::FramingMode Framing,
+    const std::vector<std::string> &Messages) {
+  std::cout << "Echo " << Name << ": ";
+  bcl::net::ServerOptions Options;
+  Options.BufferSize = 1024;
+  Options.Framing = Framing;
+  auto Client = std::make_shared<Inbox>();
+  auto S = bcl::net::connectLocal([Client](const bcl::net::ViewSocket *S) {
+    S->receive([Client](const std::string &M) { Client->push(M); });
+  }, Options);
+  if (!S) {
+    std::cout << "unable to connect" << std::endl;
+    return false;
+  }
+  for (auto &M : Messages)
+    S->send(M);
+  if (!Client->waitMessages(Messages.size())) {
+    std::cout << "timeout" << std::endl;
+    return false;
+  }
+  std::lock_guard<std::mutex> Lock(Client->Mutex);
+  for (std::size_t I = 0; I < Messages.size(); ++I)
+    if (Client->Messages[I] != "echo:" + Messages[I]) {
+      std::cout << "unexpected message " << I << std::endl;
+      return false;
+    }
+  std::cout << "ok" << std::endl;
+  return true;
+}
+
+static bool checkView() {
+  std::cout << "Take ownership of received messages: ";
+  bcl::net::ServerOptions Options;
+  Options.Framing = bcl::net::FramingMode::Delimiter;
+  // Sizes of taken messages are stored in the inbox.
+  std::vector<std::shared_ptr<const char>> Taken;
+  auto Client = std::make_shared<Inbox>();
+  auto S = bcl::net::connectLocal(
+      [Client, &Taken](const bcl::net::ViewSocket *S) {
+    S->receiveView([Client, &Taken](const bcl::net::MessageView &V) {
+      std::lock_guard<std::mutex> Lock(Client->Mutex);
+      Taken.push_back(V.take());
+      Client->Messages.push_back(std::to_string(V.size()));
+      Client->Changed.notify_all();
+    });
+  }, Options);
+  if (!S) {
+    std::cout << "unable to connect" << std::endl;
+    return false;
+  }
+  std::vector<std::string> Messages{"first", "second", "third"};
+  for (auto &M : Messages)
+    S->send(M);
+  if (!Client->waitMessages(Messages.size())) {
+    std::cout << "timeout" << std::endl;
+    return false;
+  }
+  std::lock_guard<std::mutex> Lock(Client->Mutex);
+  for (std::size_t I = 0; I < Messages.size(); ++I)
+    if (std::string(Taken[I].get(), std::stoul(Client->Messages[I])) !=
+        "echo:" + Messages[I]) {
+      std::cout << "message " << I << " is corrupted" << std::endl;
+      return false;
+    }
+  std::cout << "ok" << std::endl;
+  return true;
+}
+
+static bool checkClose() {
+  std::cout << "Close connection: ";
+  unsigned ClosedNumber;
+  {
+    std::lock_guard<std::mutex> Lock(ServerInbox.Mutex);
+    ClosedNumber = ServerInbox.ClosedNumber;
+  }
+  auto S = bcl::net::connectLocal([](const bcl::net::ViewSocket *) {});
+  if (!S) {
+    std::cout << "unable to connect" << std::endl;
+    return false;
+  }
+  S.reset();
+  if (!ServerInbox.waitClosed(ClosedNumber + 1)) {
+    std::cout << "server is not closed" << std::endl;
+    return false;
+  }
+  std::cout << "ok" << std::endl;
+  return true;
+}
+
+int main() {
+  std::cout << "BCL version " << BCL_VERSION_STRING << std::endl;
+  bool Ok = true;
+  Ok &= check("without framing", bcl::net::FramingMode::None, {"hello"});
+  Ok &= check("delimited messages", bcl::net::FramingMode::Delimiter,
+    {"first", "", std::string(5000, 'x'), "last"});
+  Ok &= check("length-prefixed messages", bcl::net::FramingMode::LengthPrefix,
+    {"first", std::string("a\0b", 3), "", std::string(100000, 'y')});
+  Ok &= checkView();
+  Ok &= checkClose();
+  return Ok ? 0 : 1;
+}
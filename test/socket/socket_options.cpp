@@ -0,0 +1,162 @@
+//===- socket_options.cpp ---- TCP Options Test -------------------*- C -*-===//
+//
+//                       Base Construction Library (BCL)
+//
+// Copyright 2018 Nikita Kataev
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements test for options of TCP connections and for binding
+// of a server to all interfaces. The server must accept IPv4 clients and,
+// if IPv6 is available, IPv6 clients on the same port.
+//
+//===----------------------------------------------------------------------===//
+
+#include <bcl/bcl-config.h>
+#include "socket_test.h"
+#include <iostream>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+using namespace bcl;
+
+namespace bcl {
+template<> void createServer<std::string>(const Socket<std::string> *S) {
+  S->receive([S](const std::string &M) { S->send("echo:" + M); });
+}
+}
+
+/// Returns a port of a specified socket address.
+static net::PortT getPort(const sockaddr_storage &Addr) {
+  return ntohs(Addr.ss_family == AF_INET6 ?
+    reinterpret_cast<const sockaddr_in6 &>(Addr).sin6_port :
+    reinterpret_cast<const sockaddr_in &>(Addr).sin_port);
+}
+
+/// Returns a server-side descriptor of a connection or -1.
+///
+/// The client and the server are in the same process, so the server-side
+/// descriptor is the one which is connected to the local port of the client.
+static int findServerSocket(const test::Client &C, net::PortT Port) {
+  sockaddr_storage Addr;
+  socklen_t Length = sizeof(Addr);
+  if (getsockname(C.fd(), (sockaddr *)&Addr, &Length) != 0)
+    return -1;
+  auto ClientPort = getPort(Addr);
+  for (int FD = 0; FD < 1024; ++FD) {
+    if (FD == C.fd())
+      continue;
+    Length = sizeof(Addr);
+    if (getsockname(FD, (sockaddr *)&Addr, &Length) != 0 ||
+        getPort(Addr) != Port)
+      continue;
+    Length = sizeof(Addr);
+    if (getpeername(FD, (sockaddr *)&Addr, &Length) == 0 &&
+        getPort(Addr) == ClientPort)
+      return FD;
+  }
+  return -1;
+}
+
+/// Returns true if an option of a socket has a specified value.
+static bool hasOption(int FD, int Level, int Name, int Value) {
+  int Opt = 0;
+  socklen_t Length = sizeof(Opt);
+  return getsockopt(FD, Level, Name, &Opt, &Length) == 0 && Opt == Value;
+}
+
+static bool checkOptions(const test::Client &C, net::PortT Port,
+    const net::ServerOptions &Options) {
+  auto FD = findServerSocket(C, Port);
+  if (FD < 0)
+    return false;
+  int Size = 0;
+  socklen_t Length = sizeof(Size);
+  // The system may increase sizes of buffers (Linux doubles them).
+  if (getsockopt(FD, SOL_SOCKET, SO_RCVBUF, &Size, &Length) != 0 ||
+      Size < Options.ReceiveBufferSize)
+    return false;
+  return hasOption(FD, IPPROTO_TCP, TCP_NODELAY, 1) &&
+#ifdef TCP_KEEPIDLE
+         hasOption(FD, IPPROTO_TCP, TCP_KEEPIDLE, Options.KeepAliveIdle) &&
+#endif
+#ifdef TCP_KEEPINTVL
+         hasOption(FD, IPPROTO_TCP, TCP_KEEPINTVL,
+                   Options.KeepAliveInterval) &&
+#endif
+#ifdef TCP_KEEPCNT
+         hasOption(FD, IPPROTO_TCP, TCP_KEEPCNT, Options.KeepAliveCount) &&
+#endif
+         hasOption(FD, SOL_SOCKET, SO_KEEPALIVE, 1);
+}
+
+/// Connects to the server, checks that a message is echoed and that options
+/// are set for the accepted connection.
+static bool check(const char *Name, const net::AddressT &Address,
+    net::PortT Port, const net::ServerOptions &Options, test::StatusLog &Log) {
+  std::cout << "Connect to " << Name << ": ";
+  auto AcceptNumber = Log.count(net::SocketStatus::Accept);
+  test::Client C;
+  std::string Message;
+  if (!C.connect(Address, Port) ||
+      !C.send(net::FramingMode::LengthPrefix, "options") ||
+      !C.receive(net::FramingMode::LengthPrefix, Message) ||
+      Message != "echo:options") {
+    std::cout << "message is not echoed" << std::endl;
+    return false;
+  }
+  // Reply is sent after a client is accepted, so the event is already logged.
+  auto Accepted = Log.events(net::SocketStatus::Accept);
+  if (Accepted.size() != AcceptNumber + 1 ||
+      Accepted.back().Connection.getClientAddress() != Address) {
+    std::cout << "unexpected client address" << std::endl;
+    return false;
+  }
+  if (!checkOptions(C, Port, Options)) {
+    std::cout << "options are not set" << std::endl;
+    return false;
+  }
+  std::cout << "ok" << std::endl;
+  return true;
+}
+
+int main() {
+  std::cout << "BCL version " << BCL_VERSION_STRING << std::endl;
+  net::ServerOptions Options;
+  Options.Mode = net::ServerMode::EventLoop;
+  Options.Framing = net::FramingMode::LengthPrefix;
+  Options.IsNoDelay = true;
+  Options.ReceiveBufferSize = 1 << 16;
+  Options.SendBufferSize = 1 << 16;
+  Options.IsKeepAlive = true;
+  Options.KeepAliveIdle = 30;
+  Options.KeepAliveInterval = 5;
+  Options.KeepAliveCount = 3;
+  auto &Log = *new test::StatusLog;
+  net::PortT Port;
+  if (!test::runServer("", Options, Log, Port)) {
+    std::cout << "Unable to start server" << std::endl;
+    return 1;
+  }
+  bool Ok = true;
+  Ok &= check("IPv4 loopback", "127.0.0.1", Port, Options, Log);
+  // The server listens IPv4 addresses only if IPv6 is not available.
+  auto ServerAddress =
+    Log.events(net::SocketStatus::Listen).back().Connection
+      .getServerAddress();
+  if (ServerAddress.find(':') != net::AddressT::npos)
+    Ok &= check("IPv6 loopback", "::1", Port, Options, Log);
+  return Ok ? 0 : 1;
+}
@@ -0,0 +1,91 @@
+//===- socket_reuse_port.cpp ---- Acceptor Sharding Test ----------*- C -*-===//
+//
+//                       Base Construction Library (BCL)
+//
+// Copyright 2018 Nikita Kataev
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements test for a C socket server with multiple sockets which
+// listen the same TCP port. All sockets must share a port chosen by the
+// system and the system must distribute connections among them.
+//
+//===----------------------------------------------------------------------===//
+
+#include <bcl/bcl-config.h>
+#include "socket_test.h"
+#include <iostream>
+#include <memory>
+#include <set>
+
+using namespace bcl;
+
+namespace bcl {
+template<> void createServer<std::string>(const Socket<std::string> *S) {
+  S->receive([S](const std::string &M) { S->send("echo:" + M); });
+}
+}
+
+int main() {
+  std::cout << "BCL version " << BCL_VERSION_STRING << std::endl;
+  std::cout << "Shard connections among acceptors: ";
+  constexpr std::size_t ClientNumber = 32;
+  net::ServerOptions Options;
+  Options.Mode = net::ServerMode::EventLoop;
+  Options.AcceptorNumber = 4;
+  Options.IsPinned = true;
+  Options.Framing = net::FramingMode::LengthPrefix;
+  auto &Log = *new test::StatusLog;
+  net::PortT Port;
+  if (!test::runServer("127.0.0.1", Options, Log, Port)) {
+    std::cout << "unable to start server" << std::endl;
+    return 1;
+  }
+  std::vector<std::unique_ptr<test::Client>> Clients;
+  for (std::size_t I = 0; I < ClientNumber; ++I) {
+    Clients.emplace_back(new test::Client);
+    if (!Clients.back()->connect("127.0.0.1", Port) ||
+        !Clients.back()->send(net::FramingMode::LengthPrefix,
+                              std::to_string(I))) {
+      std::cout << "unable to connect" << std::endl;
+      return 1;
+    }
+  }
+  for (std::size_t I = 0; I < ClientNumber; ++I) {
+    std::string Message;
+    if (!Clients[I]->receive(net::FramingMode::LengthPrefix, Message) ||
+        Message != "echo:" + std::to_string(I)) {
+      std::cout << "unexpected message " << I << std::endl;
+      return 1;
+    }
+  }
+  if (Log.count(net::SocketStatus::Listen) != 1 ||
+      Log.count(net::SocketStatus::ListenError) != 0) {
+    std::cout << "unable to listen" << std::endl;
+    return 1;
+  }
+#ifdef __linux__
+  // Connections are accepted in the thread of an acceptor.
+  std::set<std::thread::id> Acceptors;
+  for (auto &E : Log.events(net::SocketStatus::Accept))
+    Acceptors.insert(E.Thread);
+  if (Acceptors.size() < 2) {
+    std::cout << "connections are not distributed" << std::endl;
+    return 1;
+  }
+#endif
+  std::cout << "ok" << std::endl;
+  return 0;
+}
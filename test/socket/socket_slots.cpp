@@ -0,0 +1,111 @@
+//===- socket_slots.cpp ---- Connection Limit Test ----------------*- C -*-===//
+//
+//                       Base Construction Library (BCL)
+//
+// Copyright 2018 Nikita Kataev
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements test for a limit of number of active connections of
+// a C socket server. A client is accepted as soon as some active connection
+// is closed.
+//
+//===----------------------------------------------------------------------===//
+
+#include <bcl/bcl-config.h>
+#include "socket_test.h"
+#include <iostream>
+#include <memory>
+
+using namespace bcl;
+
+namespace bcl {
+template<> void createServer<std::string>(const Socket<std::string> *S) {
+  S->receive([S](const std::string &M) { S->send("echo:" + M); });
+}
+}
+
+/// Sends a message and checks that it is echoed.
+static bool echo(test::Client &C, const std::string &M) {
+  std::string Reply;
+  return C.send(M) && C.receive(5 + M.size(), Reply) && Reply == "echo:" + M;
+}
+
+static bool check(const char *Name, net::ServerMode Mode) {
+  std::cout << "Limit connections " << Name << ": ";
+  constexpr std::size_t ConnectionMaxNumber = 2;
+  net::ServerOptions Options;
+  Options.Mode = Mode;
+  Options.ConnectionMaxNumber = ConnectionMaxNumber;
+  auto &Log = *new test::StatusLog;
+  auto Address = test::unixAddress(std::string("slots-") + Name);
+  net::PortT Port;
+  if (!test::runServer(Address, Options, Log, Port)) {
+    std::cout << "unable to start server" << std::endl;
+    return false;
+  }
+  std::vector<std::unique_ptr<test::Client>> Clients;
+  for (std::size_t I = 0; I <= ConnectionMaxNumber; ++I) {
+    Clients.emplace_back(new test::Client);
+    if (!Clients.back()->connect(Address, Port)) {
+      std::cout << "unable to connect" << std::endl;
+      return false;
+    }
+  }
+  for (std::size_t I = 0; I < ConnectionMaxNumber; ++I)
+    if (!echo(*Clients[I], "active")) {
+      std::cout << "active connection is not served" << std::endl;
+      return false;
+    }
+  auto &Waiting = *Clients.back();
+  if (!Waiting.send("waiting") ||
+      Waiting.poll(std::chrono::milliseconds(200)) ||
+      Log.count(net::SocketStatus::Accept) != ConnectionMaxNumber) {
+    std::cout << "limit is exceeded" << std::endl;
+    return false;
+  }
+  Clients.front().reset();
+  std::string Reply;
+  if (!Waiting.receive(12, Reply) || Reply != "echo:waiting") {
+    std::cout << "client is not accepted after a connection is closed"
+              << std::endl;
+    return false;
+  }
+  // All slots must be released when connections are closed.
+  Clients.clear();
+  if (!Log.wait(net::SocketStatus::Close, ConnectionMaxNumber + 1)) {
+    std::cout << "connections are not closed" << std::endl;
+    return false;
+  }
+  for (std::size_t I = 0; I < ConnectionMaxNumber; ++I) {
+    Clients.emplace_back(new test::Client);
+    if (!Clients.back()->connect(Address, Port) ||
+        !echo(*Clients.back(), "again")) {
+      std::cout << "slot is not released" << std::endl;
+      return false;
+    }
+  }
+  test::removeUnixAddress(Address);
+  std::cout << "ok" << std::endl;
+  return true;
+}
+
+int main() {
+  std::cout << "BCL version " << BCL_VERSION_STRING << std::endl;
+  bool Ok = true;
+  Ok &= check("thread-per-connection", net::ServerMode::ThreadPerConnection);
+  Ok &= check("event-loop", net::ServerMode::EventLoop);
+  return Ok ? 0 : 1;
+}
@@ -0,0 +1,309 @@
+//===- socket_test.h ------- C Socket Server Test -----------------*- C -*-===//
+//
+//                       Base Construction Library (BCL)
+//
+// Copyright 2018 Nikita Kataev
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements utils to simplify testing of a C socket server which
+// is started by bcl::net::startServer(). Clients are implemented with POSIX
+// sockets, so these utils are not available on Windows.
+//
+//===----------------------------------------------------------------------===//
+
+#include <bcl/CSocket.h>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <netdb.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#ifndef MSG_NOSIGNAL
+# define MSG_NOSIGNAL 0
+#endif
+
+namespace bcl {
+namespace test {
+/// Time to wait for an expected event.
+constexpr std::chrono::seconds Timeout(5);
+
+/// Messages which are received by one side of a connection.
+struct Inbox {
+  std::mutex Mutex;
+  std::condition_variable Changed;
+  std::vector<std::string> Messages;
+
+  void push(std::string M) {
+    std::lock_guard<std::mutex> Lock(Mutex);
+    Messages.push_back(std::move(M));
+    Changed.notify_all();
+  }
+
+  /// Waits until a specified number of messages are received.
+  bool waitMessages(std::size_t Number) {
+    std::unique_lock<std::mutex> Lock(Mutex);
+    return Changed.wait_for(Lock, Timeout,
+      [this, Number]() { return Messages.size() >= Number; });
+  }
+};
+
+/// Events which are reported by a server.
+class StatusLog {
+public:
+  struct Event {
+    net::SocketStatus Status;
+    net::Connection Connection;
+    std::thread::id Thread;
+  };
+
+  void push(net::SocketStatus S, const net::Connection &C) {
+    std::lock_guard<std::mutex> Lock(mMutex);
+    mEvents.push_back(Event{S, C, std::this_thread::get_id()});
+    mChanged.notify_all();
+  }
+
+  /// Returns the number of events with a specified status.
+  std::size_t count(net::SocketStatus S) {
+    std::lock_guard<std::mutex> Lock(mMutex);
+    return countLocked(S);
+  }
+
+  /// Waits until a specified number of events with a status are reported.
+  bool wait(net::SocketStatus S, std::size_t Number = 1) {
+    std::unique_lock<std::mutex> Lock(mMutex);
+    return mChanged.wait_for(Lock, Timeout,
+      [this, S, Number]() { return countLocked(S) >= Number; });
+  }
+
+  /// Returns all events with a specified status.
+  std::vector<Event> events(net::SocketStatus S) {
+    std::lock_guard<std::mutex> Lock(mMutex);
+    std::vector<Event> Result;
+    for (auto &E : mEvents)
+      if (E.Status == S)
+        Result.push_back(E);
+    return Result;
+  }
+
+private:
+  std::size_t countLocked(net::SocketStatus S) const {
+    std::size_t Number = 0;
+    for (auto &E : mEvents)
+      Number += E.Status == S;
+    return Number;
+  }
+
+  std::mutex mMutex;
+  std::condition_variable mChanged;
+  std::vector<Event> mEvents;
+};
+
+/// Returns an address of a Unix domain socket for a specified test.
+inline net::AddressT unixAddress(const std::string &Name) {
+  return "unix:/tmp/bcl-" + Name + "-" + std::to_string(getpid()) + ".sock";
+}
+
+/// Removes a file of a Unix domain socket.
+inline void removeUnixAddress(const net::AddressT &Address) {
+  unlink(Address.c_str() + sizeof("unix:") - 1);
+}
+
+/// \brief Starts a server in a separate thread and waits until it listens
+/// for connections.
+///
+/// The server is never stopped, so the log must not be destroyed. A port is
+/// chosen by the system, it is stored in Port.
+/// \return False if the server does not listen.
+inline bool runServer(const net::AddressT &Address,
+    const net::ServerOptions &Options, StatusLog &Log, net::PortT &Port) {
+  std::thread([Address, Options, &Log]() {
+    net::startServer(Address, 0, Options,
+      [&Log](net::SocketStatus S, const net::Connection &C) {
+        Log.push(S, C);
+      });
+  }).detach();
+  if (!Log.wait(net::SocketStatus::Listen))
+    return false;
+  Port = Log.events(net::SocketStatus::Listen).back().Connection
+    .getServerPort();
+  return true;
+}
+
+/// Blocking client which is connected to a server.
+class Client {
+public:
+  Client() = default;
+  Client(const Client &) = delete;
+  Client & operator=(const Client &) = delete;
+
+  ~Client() { close(); }
+
+  /// Connects to a server, "unix:<path>" addresses are supported.
+  bool connect(const net::AddressT &Address, net::PortT Port) {
+    close();
+    sockaddr_storage Storage;
+    socklen_t Length;
+    std::memset(&Storage, 0, sizeof(Storage));
+    if (Address.compare(0, 5, "unix:") == 0) {
+      auto &Unix = reinterpret_cast<sockaddr_un &>(Storage);
+      Unix.sun_family = AF_UNIX;
+      std::strncpy(Unix.sun_path, Address.c_str() + 5,
+        sizeof(Unix.sun_path) - 1);
+      Length = sizeof(Unix);
+    } else {
+      addrinfo Hints, *List;
+      std::memset(&Hints, 0, sizeof(Hints));
+      Hints.ai_socktype = SOCK_STREAM;
+      if (getaddrinfo(Address.c_str(), std::to_string(Port).c_str(),
+                      &Hints, &List) != 0)
+        return false;
+      std::memcpy(&Storage, List->ai_addr, List->ai_addrlen);
+      Length = List->ai_addrlen;
+      freeaddrinfo(List);
+    }
+    mFD = socket(Storage.ss_family, SOCK_STREAM, 0);
+    if (mFD < 0)
+      return false;
+    timeval Time{Timeout.count(), 0};
+    setsockopt(mFD, SOL_SOCKET, SO_RCVTIMEO, &Time, sizeof(Time));
+    setsockopt(mFD, SOL_SOCKET, SO_SNDTIMEO, &Time, sizeof(Time));
+    if (::connect(mFD, (sockaddr *)&Storage, Length) != 0) {
+      close();
+      return false;
+    }
+    return true;
+  }
+
+  void close() {
+    if (mFD >= 0)
+      ::close(mFD);
+    mFD = -1;
+    mPending.clear();
+  }
+
+  int fd() const noexcept { return mFD; }
+
+  /// Sends specified data as is.
+  bool send(const std::string &Data) {
+    for (std::size_t Sent = 0; Sent < Data.size();) {
+      auto Size = ::send(mFD, Data.data() + Sent, Data.size() - Sent,
+                         MSG_NOSIGNAL);
+      if (Size <= 0)
+        return false;
+      Sent += Size;
+    }
+    return true;
+  }
+
+  /// Sends a message framed in a specified way.
+  bool send(net::FramingMode Framing, const std::string &Message,
+      const std::string &Delimiter = "\n") {
+    return send(frame(Framing, Message, Delimiter));
+  }
+
+  /// Adds a length prefix or a delimiter to a message.
+  static std::string frame(net::FramingMode Framing,
+      const std::string &Message, const std::string &Delimiter = "\n") {
+    if (Framing == net::FramingMode::Delimiter)
+      return Message + Delimiter;
+    if (Framing == net::FramingMode::None)
+      return Message;
+    std::string Prefix(4, '\0');
+    for (std::size_t I = 0; I < 4; ++I)
+      Prefix[I] = static_cast<char>(Message.size() >> (3 - I) * 8);
+    return Prefix + Message;
+  }
+
+  /// Receives exactly Size bytes.
+  bool receive(std::size_t Size, std::string &Data) {
+    while (mPending.size() < Size)
+      if (!receiveChunk())
+        return false;
+    Data = mPending.substr(0, Size);
+    mPending.erase(0, Size);
+    return true;
+  }
+
+  /// Receives a message framed in a specified way.
+  bool receive(net::FramingMode Framing, std::string &Message,
+      const std::string &Delimiter = "\n") {
+    if (Framing == net::FramingMode::LengthPrefix) {
+      std::string Prefix;
+      if (!receive(4, Prefix))
+        return false;
+      std::size_t Size = 0;
+      for (auto C : Prefix)
+        Size = (Size << 8) | static_cast<unsigned char>(C);
+      return receive(Size, Message);
+    }
+    for (;;) {
+      auto I = mPending.find(Delimiter);
+      if (I != std::string::npos) {
+        Message = mPending.substr(0, I);
+        mPending.erase(0, I + Delimiter.size());
+        return true;
+      }
+      if (!receiveChunk())
+        return false;
+    }
+  }
+
+  /// Returns true if data are available within a specified time.
+  bool poll(std::chrono::milliseconds Time) {
+    if (!mPending.empty())
+      return true;
+    pollfd P{mFD, POLLIN, 0};
+    return ::poll(&P, 1, static_cast<int>(Time.count())) > 0;
+  }
+
+  /// Reads and discards data until the server closes the connection.
+  /// \return False if the connection is not closed in time.
+  bool waitClosed() {
+    mPending.clear();
+    char Buffer[65536];
+    for (;;) {
+      auto Size = recv(mFD, Buffer, sizeof(Buffer), 0);
+      if (Size == 0)
+        return true;
+      if (Size < 0)
+        return errno == ECONNRESET;
+    }
+  }
+
+private:
+  bool receiveChunk() {
+    char Buffer[65536];
+    auto Size = recv(mFD, Buffer, sizeof(Buffer), 0);
+    if (Size <= 0)
+      return false;
+    mPending.append(Buffer, Size);
+    return true;
+  }
+
+  int mFD = -1;
+  std::string mPending;
+};
+}
+}
@@ -0,0 +1,149 @@
+//===- socket_worker_pool.cpp - Worker Pool Server Test -----------*- C -*-===//
+//
+//                       Base Construction Library (BCL)
+//
+// Copyright 2018 Nikita Kataev
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements test for a C socket server which executes listeners
+// in a worker pool. Listeners of a connection must be executed one by one in
+// the order of received messages, listeners of different connections must
+// be executed concurrently.
+//
+//===----------------------------------------------------------------------===//
+
+#include <bcl/bcl-config.h>
+#include "socket_test.h"
+#include <atomic>
+#include <iostream>
+#include <memory>
+
+using namespace bcl;
+
+namespace {
+// Listeners may be executed when the test exits, so this state is never
+// destroyed.
+std::atomic<bool> &IsOverlapped = *new std::atomic<bool>(false);
+std::mutex &GateMutex = *new std::mutex;
+std::condition_variable &GateChanged = *new std::condition_variable;
+bool IsGateOpen = false;
+}
+
+namespace bcl {
+template<> void createServer<std::string>(const Socket<std::string> *S) {
+  auto Active = std::make_shared<std::atomic<unsigned>>(0);
+  S->receive([S, Active](const std::string &M) {
+    if (++*Active > 1)
+      IsOverlapped = true;
+    if (M == "wait") {
+      // Wait for a listener of another connection.
+      std::unique_lock<std::mutex> Lock(GateMutex);
+      GateChanged.wait_for(Lock, test::Timeout, []() { return IsGateOpen; });
+    } else if (M == "open") {
+      std::lock_guard<std::mutex> Lock(GateMutex);
+      IsGateOpen = true;
+      GateChanged.notify_all();
+    } else {
+      // Later messages may be processed faster than earlier ones.
+      std::this_thread::sleep_for(
+        std::chrono::microseconds(1000 - 40 * (std::stoul(M) % 25)));
+    }
+    --*Active;
+    S->send("echo:" + M);
+  });
+}
+}
+
+static bool checkOrder(const net::AddressT &Address, net::PortT Port) {
+  std::cout << "Preserve order of messages: ";
+  constexpr std::size_t ClientNumber = 3;
+  constexpr std::size_t MessageNumber = 50;
+  std::vector<std::unique_ptr<test::Client>> Clients;
+  for (std::size_t I = 0; I < ClientNumber; ++I) {
+    Clients.emplace_back(new test::Client);
+    std::string Data;
+    for (std::size_t M = 0; M < MessageNumber; ++M)
+      Data += test::Client::frame(net::FramingMode::LengthPrefix,
+        std::to_string(M));
+    if (!Clients.back()->connect(Address, Port) ||
+        !Clients.back()->send(Data)) {
+      std::cout << "unable to send" << std::endl;
+      return false;
+    }
+  }
+  for (auto &C : Clients)
+    for (std::size_t M = 0; M < MessageNumber; ++M) {
+      std::string Message;
+      if (!C->receive(net::FramingMode::LengthPrefix, Message) ||
+          Message != "echo:" + std::to_string(M)) {
+        std::cout << "unexpected message " << M << std::endl;
+        return false;
+      }
+    }
+  if (IsOverlapped) {
+    std::cout << "listeners of a connection are executed concurrently"
+              << std::endl;
+    return false;
+  }
+  std::cout << "ok" << std::endl;
+  return true;
+}
+
+static bool checkConcurrency(const net::AddressT &Address, net::PortT Port) {
+  std::cout << "Execute listeners of different connections concurrently: ";
+  test::Client Waiting, Opening;
+  if (!Waiting.connect(Address, Port) || !Opening.connect(Address, Port) ||
+      !Waiting.send(net::FramingMode::LengthPrefix, "wait")) {
+    std::cout << "unable to send" << std::endl;
+    return false;
+  }
+  // Make sure that the first listener is waiting.
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  std::string Message;
+  if (!Opening.send(net::FramingMode::LengthPrefix, "open") ||
+      !Opening.receive(net::FramingMode::LengthPrefix, Message) ||
+      Message != "echo:open") {
+    std::cout << "listener is blocked" << std::endl;
+    return false;
+  }
+  if (!Waiting.receive(net::FramingMode::LengthPrefix, Message) ||
+      Message != "echo:wait") {
+    std::cout << "unexpected message" << std::endl;
+    return false;
+  }
+  std::cout << "ok" << std::endl;
+  return true;
+}
+
+int main() {
+  std::cout << "BCL version " << BCL_VERSION_STRING << std::endl;
+  net::ServerOptions Options;
+  Options.Mode = net::ServerMode::EventLoop;
+  Options.WorkerNumber = 4;
+  Options.Framing = net::FramingMode::LengthPrefix;
+  auto &Log = *new test::StatusLog;
+  auto Address = test::unixAddress("worker-pool");
+  net::PortT Port;
+  if (!test::runServer(Address, Options, Log, Port)) {
+    std::cout << "Unable to start server" << std::endl;
+    return 1;
+  }
+  bool Ok = true;
+  Ok &= checkOrder(Address, Port);
+  Ok &= checkConcurrency(Address, Port);
+  test::removeUnixAddress(Address);
+  return Ok ? 0 : 1;
+}